@@ -8,69 +8,367 @@
  * @brief Implementation of geometric median for a 2D grid with >= 0 targets.
  *
  */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
-#include <map>
 #include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
-// Function to find the point minimizing the distance to target points
-std::pair<int, int>
-geometric_median(const std::vector<std::vector<std::string>> &grid) {
-  if (grid.empty() || grid[0].empty()) {
-    return {-1, -1};
-  }
-
-  std::vector<std::vector<int>> distances(grid.size(),
-                                          std::vector<int>(grid[0].size(), 0));
-  std::vector<std::vector<int>> directions = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
-
-  for (int row = 0; row < grid.size(); ++row) {
-    for (int col = 0; col < grid[0].size(); ++col) {
-      if (grid[row][col] == "*") {
-        std::queue<std::pair<int, int>> to_explore;
-        std::vector<std::vector<bool>> visited(
-            grid.size(), std::vector<bool>(grid[0].size(), false));
-        std::vector<std::vector<int>> distance_per_target(
-            grid.size(), std::vector<int>(grid[0].size(), 0));
-
-        to_explore.push({row, col});
-        visited[row][col] = true;
-
-        while (!to_explore.empty()) {
-          const auto curr_node = to_explore.front();
-          to_explore.pop();
-
-          for (const auto &direction : directions) {
-            const int new_row = curr_node.first + direction[0];
-            const int new_col = curr_node.second + direction[1];
-
-            if (new_row >= 0 && new_row < grid.size() && new_col >= 0 &&
-                new_col < grid[0].size() && grid[new_row][new_col] != "#" &&
-                !visited[new_row][new_col]) {
-              to_explore.push({new_row, new_col});
-              visited[new_row][new_col] = true;
-              distance_per_target[new_row][new_col] =
-                  distance_per_target[curr_node.first][curr_node.second] + 1;
-            }
-          }
+// What a cell of the grid holds.
+enum class Cell : uint8_t { kFree, kWall, kTarget };
+
+// Grid of rows * cols cells in row major order.
+struct Grid {
+  int rows = 0;
+  int cols = 0;
+  std::vector<Cell> cells;
+
+  Grid() = default;
+  Grid(const int num_rows, const int num_cols)
+      : rows(num_rows), cols(num_cols),
+        cells(static_cast<size_t>(num_rows) * num_cols, Cell::kFree) {}
+
+  // "*" is a target, "#" a wall and anything else free.
+  explicit Grid(const std::vector<std::vector<std::string>> &grid)
+      : Grid(static_cast<int>(grid.size()),
+             grid.empty() ? 0 : static_cast<int>(grid[0].size())) {
+    for (int row = 0; row < rows; ++row) {
+      for (int col = 0; col < cols; ++col) {
+        if (grid[row][col] == "*") {
+          at(row, col) = Cell::kTarget;
+        } else if (grid[row][col] == "#") {
+          at(row, col) = Cell::kWall;
+        }
+      }
+    }
+  }
+
+  Cell &at(const int row, const int col) {
+    return cells[static_cast<size_t>(row) * cols + col];
+  }
+  Cell at(const int row, const int col) const {
+    return cells[static_cast<size_t>(row) * cols + col];
+  }
+};
+
+// Breadth first search over the free cells of a grid, 4 connected, a whole
+// level at a time. Every row of the grid is a run of 64 bit words, one bit
+// per cell, and the cells a word of the level reaches are the word shifted
+// by a cell left and right, and the words above and below it, kept where
+// the cells are free and not yet visited. Only the words holding the level
+// and their neighbours are looked at. A row of zero words is kept above and
+// below the grid, and a zero word left and right of every row, so that a
+// step never leaves the buffers.
+class GridBfs {
+public:
+  explicit GridBfs(const Grid &grid)
+      : stride_((grid.cols + 63) / 64 + 2),
+        open_(static_cast<size_t>(grid.rows + 2) * stride_, 0),
+        unvisited_(open_.size(), 0), level_(open_.size(), 0),
+        next_level_(open_.size(), 0) {
+    for (int row = 0; row < grid.rows; ++row) {
+      for (int col = 0; col < grid.cols; ++col) {
+        if (grid.at(row, col) != Cell::kWall) {
+          open_[cell(row, col) / 64] |= uint64_t{1} << (col % 64);
+        }
+      }
+    }
+  }
+
+  // Number of a cell, the index of its bit in the buffers.
+  int cell(const int row, const int col) const {
+    return ((row + 1) * stride_ + 1) * 64 + col;
+  }
+  size_t num_cells() const { return open_.size() * 64; }
+  // Row and column of a cell from its number.
+  std::pair<int, int> row_col(const int cell) const {
+    return {cell / 64 / stride_ - 1, cell % (64 * stride_) - 64};
+  }
+
+  // Turn a cell into a wall or back into a free cell.
+  void set_open(const int row, const int col, const bool open) {
+    const uint64_t bit = uint64_t{1} << (col % 64);
+    uint64_t &word = open_[cell(row, col) / 64];
+    word = open ? word | bit : word & ~bit;
+  }
+
+  // Calls visit(cell, distance) for every cell reachable from source, level
+  // by level, source included at distance 0.
+  template <typename F> void run(const int source, F visit) {
+    std::copy(open_.begin(), open_.end(), unvisited_.begin());
+    level_[source / 64] = uint64_t{1} << (source % 64);
+    unvisited_[source / 64] &= ~level_[source / 64];
+    level_words_.assign(1, source / 64);
+    visit(source, 0);
+    auto reach = [&](const int word, const int distance, uint64_t reached) {
+      reached &= unvisited_[word];
+      if (reached == 0) {
+        return;
+      }
+      if (next_level_[word] == 0) {
+        next_level_words_.push_back(word);
+      }
+      next_level_[word] |= reached;
+      unvisited_[word] &= ~reached;
+      for (; reached != 0; reached &= reached - 1) {
+        visit(word * 64 + __builtin_ctzll(reached), distance);
+      }
+    };
+    for (int distance = 1; !level_words_.empty(); ++distance) {
+      next_level_words_.clear();
+      for (const int word : level_words_) {
+        const uint64_t current = level_[word];
+        level_[word] = 0;
+        reach(word, distance, current << 1 | current >> 1);
+        reach(word - stride_, distance, current);
+        reach(word + stride_, distance, current);
+        // Cells at the ends of the word step into the words next to it.
+        if (current & 1) {
+          reach(word - 1, distance, uint64_t{1} << 63);
         }
+        if (current >> 63) {
+          reach(word + 1, distance, 1);
+        }
+      }
+      level_.swap(next_level_);
+      level_words_.swap(next_level_words_);
+    }
+  }
+
+private:
+  int stride_;
+  std::vector<uint64_t> open_;
+  // Open cells not reached yet by the search.
+  std::vector<uint64_t> unvisited_;
+  std::vector<uint64_t> level_;
+  std::vector<uint64_t> next_level_;
+  // Words holding cells of the level and of the next one.
+  std::vector<int> level_words_;
+  std::vector<int> next_level_words_;
+};
 
-        for (int i = 0; i < grid.size(); ++i) {
-          for (int j = 0; j < grid[0].size(); ++j) {
-            distances[i][j] += distance_per_target[i][j];
-          }
+// Rows and columns spanned by a block of cells, ends included.
+struct CellBox {
+  int first_row = 0;
+  int last_row = -1;
+  int first_col = 0;
+  int last_col = -1;
+};
+
+// Check if the cells which are not walls fill the box around them, so that
+// no wall stands in the way between two of them and every path length is
+// the Manhattan distance. That is a grid without walls, or with walls only
+// in a frame around it.
+bool is_open_box(const Grid &grid, CellBox *box) {
+  *box = CellBox{grid.rows, -1, grid.cols, -1};
+  size_t num_open = 0;
+  for (int row = 0; row < grid.rows; ++row) {
+    for (int col = 0; col < grid.cols; ++col) {
+      if (grid.at(row, col) != Cell::kWall) {
+        box->first_row = std::min(box->first_row, row);
+        box->last_row = std::max(box->last_row, row);
+        box->first_col = std::min(box->first_col, col);
+        box->last_col = std::max(box->last_col, col);
+        ++num_open;
+      }
+    }
+  }
+  return num_open > 0 &&
+         num_open == static_cast<size_t>(box->last_row - box->first_row + 1) *
+                         (box->last_col - box->first_col + 1);
+}
+
+// Sum of the Manhattan distances from every cell to the targets, walls
+// ignored. The sum splits into a part for the row and one for the column of
+// the cell, each a sum over a single axis made from prefix sums in
+// O(rows + cols) once the targets are counted, after which the sum at any
+// cell takes O(1).
+class ManhattanDistanceSums {
+public:
+  explicit ManhattanDistanceSums(const Grid &grid)
+      : row_sums_(grid.rows, 0), col_sums_(grid.cols, 0) {
+    // Targets in every row and column first.
+    for (int row = 0; row < grid.rows; ++row) {
+      for (int col = 0; col < grid.cols; ++col) {
+        if (grid.at(row, col) == Cell::kTarget) {
+          ++row_sums_[row];
+          ++col_sums_[col];
         }
       }
     }
+    sum_along_axis(&row_sums_);
+    sum_along_axis(&col_sums_);
+  }
+
+  int64_t at(const int row, const int col) const {
+    return row_sums_[row] + col_sums_[col];
+  }
+
+  // Cell of the box with the smallest sum, the first one in row major order
+  // on a tie: the median row and the median column of the targets, clamped
+  // to the box.
+  std::pair<int, int> median(const CellBox &box) const {
+    const auto row = std::min_element(row_sums_.begin() + box.first_row,
+                                      row_sums_.begin() + box.last_row + 1);
+    const auto col = std::min_element(col_sums_.begin() + box.first_col,
+                                      col_sums_.begin() + box.last_col + 1);
+    return {static_cast<int>(row - row_sums_.begin()),
+            static_cast<int>(col - col_sums_.begin())};
+  }
+
+private:
+  // Turn the number of targets at every position along an axis into the sum
+  // of the distances from the position to them. Going right, every target
+  // left of the position, the one just left included, adds one to the
+  // distance from the last position, and the same going left.
+  static void sum_along_axis(std::vector<int64_t> *counts_to_sums) {
+    std::vector<int64_t> &sums = *counts_to_sums;
+    const std::vector<int64_t> counts = sums;
+    const size_t size = counts.size();
+    int64_t before = 0;
+    int64_t left_sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+      left_sum += before;
+      before += counts[i];
+      sums[i] = left_sum;
+    }
+    int64_t after = 0;
+    int64_t right_sum = 0;
+    for (size_t i = size; i-- > 0;) {
+      right_sum += after;
+      after += counts[i];
+      sums[i] += right_sum;
+    }
+  }
+
+  std::vector<int64_t> row_sums_;
+  std::vector<int64_t> col_sums_;
+};
+
+// Sum over the targets of the length of the shortest path from the target to
+// every cell, in rows * cols values in row major order. Walls and the cells
+// some target cannot reach get -1.
+//
+// When the open cells fill a box the sums are the Manhattan ones, in
+// O(cells). Otherwise every target gets a search. The one from the first
+// target finds the cells all of them can reach, and the others are split
+// across num_threads threads, 0 threads using one per core, each adding into
+// its own sums which are added up at the end.
+void distance_sums(const Grid &grid, std::vector<int64_t> *sums,
+                   int num_threads = 0) {
+  sums->assign(grid.cells.size(), -1);
+  CellBox box;
+  if (is_open_box(grid, &box)) {
+    const ManhattanDistanceSums manhattan(grid);
+    for (int row = box.first_row; row <= box.last_row; ++row) {
+      for (int col = box.first_col; col <= box.last_col; ++col) {
+        (*sums)[static_cast<size_t>(row) * grid.cols + col] =
+            manhattan.at(row, col);
+      }
+    }
+    return;
+  }
+  GridBfs bfs(grid);
+  std::vector<int> targets;
+  for (int row = 0; row < grid.rows; ++row) {
+    for (int col = 0; col < grid.cols; ++col) {
+      if (grid.at(row, col) == Cell::kTarget) {
+        targets.push_back(bfs.cell(row, col));
+      }
+    }
+  }
+  if (targets.empty()) {
+    for (size_t cell = 0; cell < grid.cells.size(); ++cell) {
+      if (grid.cells[cell] != Cell::kWall) {
+        (*sums)[cell] = 0;
+      }
+    }
+    return;
+  }
+
+  // Every target reaches the cells the first one reaches, or no cell is
+  // reached by all of them and the rest of the searches are not needed.
+  std::vector<int64_t> first_sum(bfs.num_cells(), -1);
+  bfs.run(targets[0], [&](const int cell, const int distance) {
+    first_sum[cell] = distance;
+  });
+  for (const int target : targets) {
+    if (first_sum[target] < 0) {
+      return;
+    }
+  }
+
+  // Threads only pay off with enough cells to visit for each of them.
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const size_t num_rest = targets.size() - 1;
+  const size_t min_visits_per_thread = 1 << 16;
+  const size_t num_chunks = std::max<size_t>(
+      1, std::min({static_cast<size_t>(num_threads), num_rest,
+                   num_rest * grid.cells.size() / min_visits_per_thread}));
+  std::vector<std::vector<int64_t>> chunk_sums(num_chunks);
+  auto add_targets = [&](const size_t chunk) {
+    GridBfs chunk_bfs(grid);
+    std::vector<int64_t> &chunk_sum = chunk_sums[chunk];
+    chunk_sum.assign(chunk_bfs.num_cells(), 0);
+    const size_t first = 1 + num_rest * chunk / num_chunks;
+    const size_t last = 1 + num_rest * (chunk + 1) / num_chunks;
+    for (size_t target = first; target < last; ++target) {
+      chunk_bfs.run(targets[target], [&](const int cell, const int distance) {
+        chunk_sum[cell] += distance;
+      });
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    threads.emplace_back(add_targets, chunk);
+  }
+  add_targets(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int row = 0; row < grid.rows; ++row) {
+    for (int col = 0; col < grid.cols; ++col) {
+      const int cell = bfs.cell(row, col);
+      if (first_sum[cell] < 0) {
+        continue;
+      }
+      int64_t sum = first_sum[cell];
+      for (const auto &chunk_sum : chunk_sums) {
+        sum += chunk_sum[cell];
+      }
+      (*sums)[static_cast<size_t>(row) * grid.cols + col] = sum;
+    }
   }
+}
 
-  int min_row, min_col = -1;
-  int min_distance = std::numeric_limits<int>::max();
-  for (int row = 0; row < distances.size(); ++row) {
-    for (int col = 0; col < distances[0].size(); ++col) {
-      if (grid[row][col] != "#" && distances[row][col] < min_distance) {
-        min_distance = distances[row][col];
+// Function to find the point minimizing the distance to target points. The
+// first one in row major order wins a tie, and (-1, -1) means that no cell is
+// reachable from every target.
+std::pair<int, int> geometric_median(const Grid &grid, int num_threads = 0) {
+  CellBox box;
+  if (is_open_box(grid, &box)) {
+    return ManhattanDistanceSums(grid).median(box);
+  }
+  std::vector<int64_t> sums;
+  distance_sums(grid, &sums, num_threads);
+  int min_row = -1;
+  int min_col = -1;
+  int64_t min_distance = std::numeric_limits<int64_t>::max();
+  for (int row = 0; row < grid.rows; ++row) {
+    for (int col = 0; col < grid.cols; ++col) {
+      const int64_t distance = sums[static_cast<size_t>(row) * grid.cols + col];
+      if (distance >= 0 && distance < min_distance) {
+        min_distance = distance;
         min_row = row;
         min_col = col;
       }
@@ -79,6 +377,328 @@ geometric_median(const std::vector<std::vector<std::string>> &grid) {
   return {min_row, min_col};
 }
 
+std::pair<int, int>
+geometric_median(const std::vector<std::vector<std::string>> &grid,
+                 int num_threads = 0) {
+  return geometric_median(Grid(grid), num_threads);
+}
+
+// Geometric median of a grid whose targets and walls change between
+// queries. The distances from every target are kept, along with their sum
+// and the number of targets reaching every cell, and a tournament tree over
+// the cells holds the one with the smallest sum. Adding or removing a target
+// takes one search, and putting or taking away a wall only redoes the
+// distances which change, instead of a search per target every time. Keeps
+// rows * cols distances for every target.
+class GeometricMedianSolver {
+public:
+  explicit GeometricMedianSolver(const Grid &grid)
+      : grid_(grid), bfs_(grid), sums_(grid.cells.size(), 0),
+        reached_(grid.cells.size(), 0), tree_(2 * grid.cells.size()) {
+    for (size_t index = 0; index < grid_.cells.size(); ++index) {
+      if (grid_.cells[index] == Cell::kTarget) {
+        add_distances(static_cast<int>(index));
+      }
+    }
+    build_tree();
+  }
+
+  // Put a target on a free cell. false if the cell is a wall or a target.
+  bool add_target(const int row, const int col) {
+    if (grid_.at(row, col) != Cell::kFree) {
+      return false;
+    }
+    grid_.at(row, col) = Cell::kTarget;
+    add_distances(row * grid_.cols + col);
+    // The number of targets every cell must be reached by changes.
+    build_tree();
+    return true;
+  }
+
+  // false if the cell is not a target.
+  bool remove_target(const int row, const int col) {
+    if (grid_.at(row, col) != Cell::kTarget) {
+      return false;
+    }
+    grid_.at(row, col) = Cell::kFree;
+    const int index = row * grid_.cols + col;
+    const auto target =
+        std::find_if(targets_.begin(), targets_.end(),
+                     [&](const Target &other) { return other.index == index; });
+    for (size_t cell = 0; cell < grid_.cells.size(); ++cell) {
+      set_distance(&*target, static_cast<int>(cell), -1);
+    }
+    std::swap(*target, targets_.back());
+    targets_.pop_back();
+    build_tree();
+    return true;
+  }
+
+  // Put a wall on a cell, or take it away. A wall on a target removes the
+  // target.
+  void set_wall(const int row, const int col, const bool wall) {
+    if ((grid_.at(row, col) == Cell::kWall) == wall) {
+      return;
+    }
+    if (grid_.at(row, col) == Cell::kTarget) {
+      remove_target(row, col);
+    }
+    grid_.at(row, col) = wall ? Cell::kWall : Cell::kFree;
+    bfs_.set_open(row, col, !wall);
+    const int index = row * grid_.cols + col;
+    changed_.assign(1, index);
+    for (auto &target : targets_) {
+      if (wall) {
+        block(&target, index);
+      } else {
+        unblock(&target, index);
+      }
+    }
+    // Walking up the tree from every changed cell only pays off for a few.
+    if (changed_.size() > grid_.cells.size() / 16) {
+      build_tree();
+    } else {
+      for (const int cell : changed_) {
+        update_tree(cell);
+      }
+    }
+  }
+
+  // Same as geometric_median on the grid as it is now.
+  std::pair<int, int> median() const {
+    if (grid_.cells.empty() || key(tree_[1]) < 0) {
+      return {-1, -1};
+    }
+    return {tree_[1] / grid_.cols, tree_[1] % grid_.cols};
+  }
+
+  // Sum of the distances from the targets to a cell, -1 for a wall or a cell
+  // some target cannot reach, as in distance_sums.
+  int64_t distance_sum(const int row, const int col) const {
+    return key(row * grid_.cols + col);
+  }
+
+  const Grid &grid() const { return grid_; }
+
+private:
+  struct Target {
+    int index;
+    // Distance from the target to every cell, -1 when it cannot reach it.
+    std::vector<int> distances;
+  };
+
+  // Sum of the distances to a cell, or -1 if it does not count.
+  int64_t key(const int index) const {
+    return grid_.cells[index] != Cell::kWall &&
+                   reached_[index] == static_cast<int>(targets_.size())
+               ? sums_[index]
+               : -1;
+  }
+
+  // Check if a cell is a better median than another, the first one in row
+  // major order on a tie.
+  bool is_better(const int index, const int other) const {
+    const int64_t sum = key(index);
+    const int64_t other_sum = key(other);
+    if ((sum < 0) != (other_sum < 0)) {
+      return sum >= 0;
+    }
+    return sum != other_sum ? sum < other_sum : index < other;
+  }
+
+  // The leaves are at size + index, and every node above holds the better
+  // cell of its two children, so the root tree_[1] holds the median.
+  void build_tree() {
+    changed_.clear();
+    const size_t size = grid_.cells.size();
+    for (size_t index = 0; index < size; ++index) {
+      tree_[size + index] = static_cast<int>(index);
+    }
+    for (size_t node = size; node-- > 1;) {
+      const int left = tree_[2 * node];
+      const int right = tree_[2 * node + 1];
+      tree_[node] = is_better(right, left) ? right : left;
+    }
+  }
+
+  void update_tree(const int index) {
+    for (size_t node = (grid_.cells.size() + index) / 2; node >= 1;
+         node /= 2) {
+      const int left = tree_[2 * node];
+      const int right = tree_[2 * node + 1];
+      tree_[node] = is_better(right, left) ? right : left;
+    }
+  }
+
+  void add_distances(const int index) {
+    targets_.push_back({index, std::vector<int>(grid_.cells.size(), -1)});
+    Target &target = targets_.back();
+    bfs_.run(bfs_.cell(index / grid_.cols, index % grid_.cols),
+             [&](const int cell, const int distance) {
+               const auto row_col = bfs_.row_col(cell);
+               set_distance(&target, row_col.first * grid_.cols + row_col.second,
+                            distance);
+             });
+  }
+
+  // Change the distance from a target to a cell, and the sums with it.
+  void set_distance(Target *target, const int index, const int distance) {
+    int &old_distance = target->distances[index];
+    if (old_distance >= 0) {
+      sums_[index] -= old_distance;
+      --reached_[index];
+    }
+    if (distance >= 0) {
+      sums_[index] += distance;
+      ++reached_[index];
+    }
+    old_distance = distance;
+    changed_.push_back(index);
+  }
+
+  template <typename F> void for_each_neighbour(const int index, F f) const {
+    const int row = index / grid_.cols;
+    const int col = index % grid_.cols;
+    if (row > 0) {
+      f(index - grid_.cols);
+    }
+    if (row + 1 < grid_.rows) {
+      f(index + grid_.cols);
+    }
+    if (col > 0) {
+      f(index - 1);
+    }
+    if (col + 1 < grid_.cols) {
+      f(index + 1);
+    }
+  }
+
+  // The cell which just became a wall may have been on the shortest paths
+  // from the target. The cells left without a neighbour one step closer to
+  // the target, going away from the wall a level at a time, are the ones
+  // whose distance changes. They get it again from their other neighbours,
+  // closest first.
+  void block(Target *target, const int wall) {
+    std::vector<int> &distances = target->distances;
+    const int wall_distance = distances[wall];
+    if (wall_distance < 0) {
+      return;
+    }
+    set_distance(target, wall, -1);
+    // Marks at search_ for the cells looked at, search_ + 1 for the ones
+    // whose distance changes.
+    if (mark_.empty() || search_ > std::numeric_limits<uint32_t>::max() - 2) {
+      mark_.assign(grid_.cells.size(), 0);
+      search_ = 0;
+    }
+    search_ += 2;
+    const uint32_t seen = search_;
+    const uint32_t lost = search_ + 1;
+    queue_.clear();
+    for_each_neighbour(wall, [&](const int next) {
+      if (distances[next] == wall_distance + 1) {
+        queue_.push_back(next);
+      }
+    });
+    lost_.clear();
+    for (size_t head = 0; head < queue_.size(); ++head) {
+      const int cell = queue_[head];
+      if (mark_[cell] >= seen) {
+        continue;
+      }
+      mark_[cell] = seen;
+      bool kept = false;
+      for_each_neighbour(cell, [&](const int next) {
+        kept |= distances[next] == distances[cell] - 1 && mark_[next] != lost;
+      });
+      if (kept) {
+        continue;
+      }
+      mark_[cell] = lost;
+      lost_.push_back(cell);
+      for_each_neighbour(cell, [&](const int next) {
+        if (distances[next] == distances[cell] + 1) {
+          queue_.push_back(next);
+        }
+      });
+    }
+
+    for (const int cell : lost_) {
+      set_distance(target, cell, -1);
+    }
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
+                        std::greater<std::pair<int, int>>>
+        closest;
+    for (const int cell : lost_) {
+      int distance = -1;
+      for_each_neighbour(cell, [&](const int next) {
+        if (distances[next] >= 0 &&
+            (distance < 0 || distances[next] + 1 < distance)) {
+          distance = distances[next] + 1;
+        }
+      });
+      if (distance >= 0) {
+        closest.push({distance, cell});
+      }
+    }
+    while (!closest.empty()) {
+      const auto [distance, cell] = closest.top();
+      closest.pop();
+      if (distances[cell] >= 0) {
+        continue;
+      }
+      set_distance(target, cell, distance);
+      for_each_neighbour(cell, [&](const int next) {
+        if (mark_[next] == lost && distances[next] < 0) {
+          closest.push({distance + 1, next});
+        }
+      });
+    }
+  }
+
+  // The cell which just stopped being a wall gets its distance from its
+  // neighbours, and the shorter paths through it spread out from there.
+  void unblock(Target *target, const int opened) {
+    std::vector<int> &distances = target->distances;
+    int distance = -1;
+    for_each_neighbour(opened, [&](const int next) {
+      if (distances[next] >= 0 &&
+          (distance < 0 || distances[next] + 1 < distance)) {
+        distance = distances[next] + 1;
+      }
+    });
+    if (distance < 0) {
+      return;
+    }
+    set_distance(target, opened, distance);
+    queue_.assign(1, opened);
+    for (size_t head = 0; head < queue_.size(); ++head) {
+      const int cell = queue_[head];
+      for_each_neighbour(cell, [&](const int next) {
+        if (grid_.cells[next] != Cell::kWall &&
+            (distances[next] < 0 || distances[next] > distances[cell] + 1)) {
+          set_distance(target, next, distances[cell] + 1);
+          queue_.push_back(next);
+        }
+      });
+    }
+  }
+
+  Grid grid_;
+  GridBfs bfs_;
+  std::vector<Target> targets_;
+  std::vector<int64_t> sums_;
+  std::vector<int> reached_;
+  std::vector<int> tree_;
+  // Cells whose sum changed since the last update of the tree.
+  std::vector<int> changed_;
+  // Buffers of the repairs after a wall change.
+  std::vector<uint32_t> mark_;
+  uint32_t search_ = 0;
+  std::vector<int> queue_;
+  std::vector<int> lost_;
+};
+
 int main() {
   // Test Case 1: Simple 3x3 grid
   std::vector<std::vector<std::string>> grid1 = {
@@ -118,11 +738,31 @@ int main() {
       {" ", " ", " ", " ", " ", " "},
       {"*", " ", " ", " ", " ", "*"}}; // Median point: (2, 2)
 
+  // Test Case 6: Walled off corner no target can reach
+  std::vector<std::vector<std::string>> grid6 = {
+      {" ", "#", " ", " "},
+      {"#", " ", "*", " "},
+      {" ", " ", " ", "*"},
+      {" ", " ", " ", " "}}; // Median point: (1, 2)
+
+  // Test Case 7: Targets cut off from each other
+  std::vector<std::vector<std::string>> grid7 = {
+      {"*", "#", "*"},
+      {" ", "#", " "}}; // No median point: (-1, -1)
+
+  // Test Case 8: Walls only in a frame around the grid
+  std::vector<std::vector<std::string>> grid8 = {
+      {"#", "#", "#", "#", "#"},
+      {"#", "*", " ", " ", "#"},
+      {"#", " ", " ", "*", "#"},
+      {"#", " ", "*", " ", "#"},
+      {"#", "#", "#", "#", "#"}}; // Median point: (2, 2)
+
   // Run tests
   std::vector<std::vector<std::vector<std::string>>> test_cases = {
-      grid1, grid2, grid3, grid4, grid5};
+      grid1, grid2, grid3, grid4, grid5, grid6, grid7, grid8};
   std::vector<std::pair<int, int>> expected_results = {
-      {1, 1}, {2, 2}, {2, 2}, {4, 3}, {2, 2}};
+      {1, 1}, {2, 2}, {2, 2}, {4, 3}, {2, 2}, {1, 2}, {-1, -1}, {2, 2}};
 
   for (size_t i = 0; i < test_cases.size(); ++i) {
     std::pair<int, int> result = geometric_median(test_cases[i]);
@@ -136,5 +776,83 @@ int main() {
     }
   }
 
+  // Large grid with a tenth of the cells walls, one thread against one per
+  // core.
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  Grid large(600, 600);
+  for (auto &cell : large.cells) {
+    const double draw = uniform(generator);
+    cell = draw < 0.1 ? Cell::kWall
+                      : (draw < 0.1004 ? Cell::kTarget : Cell::kFree);
+  }
+  auto time_ms = [](const auto &f) {
+    const auto time_start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - time_start)
+        .count();
+  };
+  std::pair<int, int> serial;
+  std::pair<int, int> parallel;
+  const double serial_ms =
+      time_ms([&] { serial = geometric_median(large, 1); });
+  const double parallel_ms =
+      time_ms([&] { parallel = geometric_median(large); });
+  std::cout << "600x600 grid, "
+            << std::count(large.cells.begin(), large.cells.end(),
+                          Cell::kTarget)
+            << " targets: " << serial_ms << " ms on one thread, "
+            << parallel_ms << " ms on "
+            << std::max(1u, std::thread::hardware_concurrency())
+            << " (same result: " << (serial == parallel ? "yes" : "no")
+            << ")\n";
+
+  // Without the walls the sums are the Manhattan ones.
+  for (auto &cell : large.cells) {
+    cell = cell == Cell::kWall ? Cell::kFree : cell;
+  }
+  std::vector<int64_t> sums;
+  const double median_ms = time_ms([&] { serial = geometric_median(large); });
+  const double sums_ms = time_ms([&] { distance_sums(large, &sums); });
+  std::cout << "600x600 grid without walls: " << median_ms
+            << " ms for the median, " << sums_ms << " ms for every sum\n";
+
+  // Targets and walls coming and going on a 200x200 grid, kept up to date
+  // against solved again every time.
+  Grid changing(200, 200);
+  for (auto &cell : changing.cells) {
+    const double draw = uniform(generator);
+    cell = draw < 0.1 ? Cell::kWall
+                      : (draw < 0.101 ? Cell::kTarget : Cell::kFree);
+  }
+  GeometricMedianSolver solver(changing);
+  std::vector<std::pair<int, int>> incremental;
+  std::vector<std::pair<int, int>> from_scratch;
+  std::uniform_int_distribution<int> coordinate(0, 199);
+  double incremental_ms = 0;
+  double from_scratch_ms = 0;
+  for (int update = 0; update < 200; ++update) {
+    const int row = coordinate(generator);
+    const int col = coordinate(generator);
+    incremental_ms += time_ms([&] {
+      // Mostly walls, now and then a target.
+      if (update % 10 == 0) {
+        solver.add_target(row, col);
+      } else if (update % 10 == 5) {
+        solver.remove_target(row, col);
+      } else {
+        solver.set_wall(row, col, update % 2 == 0);
+      }
+      incremental.push_back(solver.median());
+    });
+    from_scratch_ms += time_ms(
+        [&] { from_scratch.push_back(geometric_median(solver.grid(), 1)); });
+  }
+  std::cout << "200 updates of a 200x200 grid: " << incremental_ms
+            << " ms kept up to date, " << from_scratch_ms
+            << " ms solved again (same result: "
+            << (incremental == from_scratch ? "yes" : "no") << ")\n";
+
   return 0;
 }
@@ -1,5 +1,18 @@
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 // Top Left Corner of the rectangle
 struct Rect {
@@ -27,11 +40,1149 @@ double GetIou(const Rect &a, const Rect &b) {
   return (iou_area / (a.length * a.breadth + b.length * b.breadth - iou_area));
 }
 
+// Many rectangles stored as one array per coordinate, with the corners and
+// the area computed once, so that the IoU of a box against many others is
+// computed several boxes at a time.
+template <typename T>
+struct Boxes {
+  std::vector<T> x_min;
+  std::vector<T> y_min;
+  std::vector<T> x_max;
+  std::vector<T> y_max;
+  std::vector<T> area;
+
+  Boxes() = default;
+  explicit Boxes(const std::vector<Rect> &rects) {
+    Reserve(rects.size());
+    for (const auto &rect : rects) {
+      Add(rect);
+    }
+  }
+
+  void Reserve(const size_t size) {
+    x_min.reserve(size);
+    y_min.reserve(size);
+    x_max.reserve(size);
+    y_max.reserve(size);
+    area.reserve(size);
+  }
+
+  void Add(const Rect &rect) {
+    x_min.push_back(static_cast<T>(rect.x));
+    y_min.push_back(static_cast<T>(rect.y));
+    x_max.push_back(static_cast<T>(rect.x + rect.length));
+    y_max.push_back(static_cast<T>(rect.y + rect.breadth));
+    area.push_back(static_cast<T>(rect.length * rect.breadth));
+  }
+
+  size_t size() const { return x_min.size(); }
+};
+
+// IoU of box i of a and box j of b, the same as GetIou on the rectangles.
+template <typename T>
+T GetIou(const Boxes<T> &a, const size_t i, const Boxes<T> &b,
+         const size_t j) {
+  const T intersecting_length =
+      std::min(a.x_max[i], b.x_max[j]) - std::max(a.x_min[i], b.x_min[j]);
+  const T intersecting_breadth =
+      std::min(a.y_max[i], b.y_max[j]) - std::max(a.y_min[i], b.y_min[j]);
+  if (intersecting_length < 0 || intersecting_breadth < 0) {
+    return 0;
+  }
+  const T iou_area = intersecting_length * intersecting_breadth;
+  return iou_area / (a.area[i] + b.area[j] - iou_area);
+}
+
+#ifdef __AVX2__
+// IoU of box i of a against the boxes of b, 4 doubles or 8 floats at a time.
+// Returns the number of boxes of b done, the remaining ones are left to the
+// scalar GetIou.
+size_t GetIouRowSimd(const Boxes<double> &a, const size_t i,
+                     const Boxes<double> &b, double *iou) {
+  const __m256d a_x_min = _mm256_set1_pd(a.x_min[i]);
+  const __m256d a_y_min = _mm256_set1_pd(a.y_min[i]);
+  const __m256d a_x_max = _mm256_set1_pd(a.x_max[i]);
+  const __m256d a_y_max = _mm256_set1_pd(a.y_max[i]);
+  const __m256d a_area = _mm256_set1_pd(a.area[i]);
+  const __m256d zero = _mm256_setzero_pd();
+  size_t j = 0;
+  for (; j + 4 <= b.size(); j += 4) {
+    const __m256d length =
+        _mm256_sub_pd(_mm256_min_pd(a_x_max, _mm256_loadu_pd(&b.x_max[j])),
+                      _mm256_max_pd(a_x_min, _mm256_loadu_pd(&b.x_min[j])));
+    const __m256d breadth =
+        _mm256_sub_pd(_mm256_min_pd(a_y_max, _mm256_loadu_pd(&b.y_max[j])),
+                      _mm256_max_pd(a_y_min, _mm256_loadu_pd(&b.y_min[j])));
+    const __m256d iou_area = _mm256_mul_pd(length, breadth);
+    const __m256d union_area = _mm256_sub_pd(
+        _mm256_add_pd(a_area, _mm256_loadu_pd(&b.area[j])), iou_area);
+    const __m256d disjoint =
+        _mm256_or_pd(_mm256_cmp_pd(length, zero, _CMP_LT_OQ),
+                     _mm256_cmp_pd(breadth, zero, _CMP_LT_OQ));
+    _mm256_storeu_pd(
+        iou + j,
+        _mm256_andnot_pd(disjoint, _mm256_div_pd(iou_area, union_area)));
+  }
+  return j;
+}
+
+size_t GetIouRowSimd(const Boxes<float> &a, const size_t i,
+                     const Boxes<float> &b, float *iou) {
+  const __m256 a_x_min = _mm256_set1_ps(a.x_min[i]);
+  const __m256 a_y_min = _mm256_set1_ps(a.y_min[i]);
+  const __m256 a_x_max = _mm256_set1_ps(a.x_max[i]);
+  const __m256 a_y_max = _mm256_set1_ps(a.y_max[i]);
+  const __m256 a_area = _mm256_set1_ps(a.area[i]);
+  const __m256 zero = _mm256_setzero_ps();
+  size_t j = 0;
+  for (; j + 8 <= b.size(); j += 8) {
+    const __m256 length =
+        _mm256_sub_ps(_mm256_min_ps(a_x_max, _mm256_loadu_ps(&b.x_max[j])),
+                      _mm256_max_ps(a_x_min, _mm256_loadu_ps(&b.x_min[j])));
+    const __m256 breadth =
+        _mm256_sub_ps(_mm256_min_ps(a_y_max, _mm256_loadu_ps(&b.y_max[j])),
+                      _mm256_max_ps(a_y_min, _mm256_loadu_ps(&b.y_min[j])));
+    const __m256 iou_area = _mm256_mul_ps(length, breadth);
+    const __m256 union_area = _mm256_sub_ps(
+        _mm256_add_ps(a_area, _mm256_loadu_ps(&b.area[j])), iou_area);
+    const __m256 disjoint =
+        _mm256_or_ps(_mm256_cmp_ps(length, zero, _CMP_LT_OQ),
+                     _mm256_cmp_ps(breadth, zero, _CMP_LT_OQ));
+    _mm256_storeu_ps(
+        iou + j,
+        _mm256_andnot_ps(disjoint, _mm256_div_ps(iou_area, union_area)));
+  }
+  return j;
+}
+#else
+template <typename T>
+size_t GetIouRowSimd(const Boxes<T> &, const size_t, const Boxes<T> &, T *) {
+  return 0;
+}
+#endif
+
+// Calls fill_rows(begin, end) on ranges of the rows of a rows x cols matrix,
+// split across num_threads threads, 0 threads using one per core. Threads
+// only pay off with at least min_pairs_per_thread pairs for each of them.
+template <typename F>
+void ParallelForRows(const size_t rows, const size_t cols, int num_threads,
+                     const size_t min_pairs_per_thread, F fill_rows) {
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const size_t max_threads = std::max<size_t>(
+      1, std::min(rows, rows * cols / min_pairs_per_thread));
+  const size_t num_chunks =
+      std::min(static_cast<size_t>(num_threads), max_threads);
+  std::vector<std::thread> threads;
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    threads.emplace_back(fill_rows, rows * chunk / num_chunks,
+                         rows * (chunk + 1) / num_chunks);
+  }
+  fill_rows(0, rows / num_chunks);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// Fills iou with the IoU of every box of a (rows) against every box of b
+// (columns), splitting the rows across num_threads threads. 0 threads uses
+// one per core.
+template <typename T>
+void GetIouMatrix(const Boxes<T> &a, const Boxes<T> &b, std::vector<T> *iou,
+                  int num_threads = 0) {
+  const size_t cols = b.size();
+  iou->resize(a.size() * cols);
+  ParallelForRows(a.size(), cols, num_threads, 1 << 16,
+                  [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                      T *row = iou->data() + i * cols;
+                      for (size_t j = GetIouRowSimd(a, i, b, row); j < cols;
+                           ++j) {
+                        row[j] = GetIou(a, i, b, j);
+                      }
+                    }
+                  });
+}
+
+// Rectangle rotated by yaw, anticlockwise in radians, around its center. With
+// a yaw of 0 its length is along x and its breadth along y.
+struct RotatedRect {
+  double center_x;
+  double center_y;
+  double length;
+  double breadth;
+  double yaw;
+};
+
+// Box of a 3D detection, rotated by yaw around the z axis, e.g. from a lidar.
+struct Box3d {
+  double center_x;
+  double center_y;
+  double center_z;
+  double length;
+  double breadth;
+  double height;
+  double yaw;
+};
+
+struct Point {
+  double x;
+  double y;
+};
+
+// A rotated rectangle with its corners and bounds computed once, for the
+// IoU against many others.
+struct RotatedBox {
+  Point corners[4];  // Anticlockwise.
+  Point center;
+  double radius;  // Of the circle around the corners.
+  double x_min;
+  double y_min;
+  double x_max;
+  double y_max;
+  double area;
+
+  explicit RotatedBox(const RotatedRect &rect)
+      : center{rect.center_x, rect.center_y},
+        radius(0.5 * std::hypot(rect.length, rect.breadth)),
+        area(rect.length * rect.breadth) {
+    const double cos_yaw = std::cos(rect.yaw);
+    const double sin_yaw = std::sin(rect.yaw);
+    const double half_length = 0.5 * rect.length;
+    const double half_breadth = 0.5 * rect.breadth;
+    const double signs[4][2] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+    for (int i = 0; i < 4; ++i) {
+      const double along = signs[i][0] * half_length;
+      const double across = signs[i][1] * half_breadth;
+      corners[i] = {center.x + along * cos_yaw - across * sin_yaw,
+                    center.y + along * sin_yaw + across * cos_yaw};
+    }
+    x_min = x_max = corners[0].x;
+    y_min = y_max = corners[0].y;
+    for (const auto &corner : corners) {
+      x_min = std::min(x_min, corner.x);
+      x_max = std::max(x_max, corner.x);
+      y_min = std::min(y_min, corner.y);
+      y_max = std::max(y_max, corner.y);
+    }
+  }
+};
+
+// Area of the intersection of two rotated rectangles, by clipping the first
+// with every side of the second (Sutherland-Hodgman).
+double GetIntersectionArea(const RotatedBox &a, const RotatedBox &b) {
+  // Every side clipping a convex polygon adds at most one vertex.
+  Point polygon[8];
+  Point clipped[8];
+  int size = 4;
+  std::copy(a.corners, a.corners + 4, polygon);
+  for (int side = 0; side < 4 && size > 0; ++side) {
+    const Point &start = b.corners[side];
+    const Point &end = b.corners[(side + 1) % 4];
+    const double side_x = end.x - start.x;
+    const double side_y = end.y - start.y;
+    // Left of the side is inside the second rectangle.
+    auto inside = [&](const Point &point) {
+      return side_x * (point.y - start.y) - side_y * (point.x - start.x);
+    };
+    int clipped_size = 0;
+    Point previous = polygon[size - 1];
+    double previous_inside = inside(previous);
+    for (int i = 0; i < size; ++i) {
+      const Point &current = polygon[i];
+      const double current_inside = inside(current);
+      if ((current_inside >= 0) != (previous_inside >= 0)) {
+        const double t = previous_inside / (previous_inside - current_inside);
+        clipped[clipped_size++] = {previous.x + t * (current.x - previous.x),
+                                   previous.y + t * (current.y - previous.y)};
+      }
+      if (current_inside >= 0) {
+        clipped[clipped_size++] = current;
+      }
+      previous = current;
+      previous_inside = current_inside;
+    }
+    std::copy(clipped, clipped + clipped_size, polygon);
+    size = clipped_size;
+  }
+  double twice_area = 0.0;
+  for (int i = 0; i < size; ++i) {
+    const Point &current = polygon[i];
+    const Point &next = polygon[(i + 1) % size];
+    twice_area += current.x * next.y - next.x * current.y;
+  }
+  return 0.5 * std::abs(twice_area);
+}
+
+// Rectangles far enough apart do not need to be clipped: their circles or
+// their axis aligned bounds do not overlap.
+bool AreApart(const RotatedBox &a, const RotatedBox &b) {
+  const double dx = a.center.x - b.center.x;
+  const double dy = a.center.y - b.center.y;
+  const double radii = a.radius + b.radius;
+  return dx * dx + dy * dy > radii * radii || a.x_min > b.x_max ||
+         b.x_min > a.x_max || a.y_min > b.y_max || b.y_min > a.y_max;
+}
+
+double GetRotatedIou(const RotatedBox &a, const RotatedBox &b) {
+  if (AreApart(a, b)) {
+    return 0.0;
+  }
+  const double iou_area = GetIntersectionArea(a, b);
+  return iou_area / (a.area + b.area - iou_area);
+}
+
+double GetRotatedIou(const RotatedRect &a, const RotatedRect &b) {
+  return GetRotatedIou(RotatedBox(a), RotatedBox(b));
+}
+
+// A 3D box with its footprint in bird's eye view and its vertical extent
+// computed once.
+struct RotatedBox3d {
+  RotatedBox footprint;
+  double z_min;
+  double z_max;
+  double volume;
+
+  explicit RotatedBox3d(const Box3d &box)
+      : footprint(RotatedRect{box.center_x, box.center_y, box.length,
+                              box.breadth, box.yaw}),
+        z_min(box.center_z - 0.5 * box.height),
+        z_max(box.center_z + 0.5 * box.height),
+        volume(box.length * box.breadth * box.height) {}
+};
+
+// IoU of the volumes: the boxes only rotate around z, so their intersection
+// is the intersection of their footprints times the overlap of their heights.
+double GetIou3d(const RotatedBox3d &a, const RotatedBox3d &b) {
+  const double overlap_height =
+      std::min(a.z_max, b.z_max) - std::max(a.z_min, b.z_min);
+  if (overlap_height <= 0 || AreApart(a.footprint, b.footprint)) {
+    return 0.0;
+  }
+  const double iou_volume =
+      GetIntersectionArea(a.footprint, b.footprint) * overlap_height;
+  return iou_volume / (a.volume + b.volume - iou_volume);
+}
+
+double GetIou3d(const Box3d &a, const Box3d &b) {
+  return GetIou3d(RotatedBox3d(a), RotatedBox3d(b));
+}
+
+// Fills iou with the IoU of every box of a (rows) against every box of b
+// (columns), the corners and bounds of every box computed once and the rows
+// split across num_threads threads. 0 threads uses one per core.
+template <typename Prepared, typename Box, typename F>
+void GetPairwiseIou(const std::vector<Box> &a, const std::vector<Box> &b,
+                    std::vector<double> *iou, const int num_threads,
+                    F get_iou) {
+  const std::vector<Prepared> prepared_a(a.begin(), a.end());
+  const std::vector<Prepared> prepared_b(b.begin(), b.end());
+  const size_t cols = b.size();
+  iou->resize(a.size() * cols);
+  ParallelForRows(a.size(), cols, num_threads, 1 << 12,
+                  [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                      for (size_t j = 0; j < cols; ++j) {
+                        (*iou)[i * cols + j] =
+                            get_iou(prepared_a[i], prepared_b[j]);
+                      }
+                    }
+                  });
+}
+
+void GetRotatedIouMatrix(const std::vector<RotatedRect> &a,
+                         const std::vector<RotatedRect> &b,
+                         std::vector<double> *iou, int num_threads = 0) {
+  GetPairwiseIou<RotatedBox>(
+      a, b, iou, num_threads,
+      [](const RotatedBox &first, const RotatedBox &second) {
+        return GetRotatedIou(first, second);
+      });
+}
+
+void GetIou3dMatrix(const std::vector<Box3d> &a, const std::vector<Box3d> &b,
+                    std::vector<double> *iou, int num_threads = 0) {
+  GetPairwiseIou<RotatedBox3d>(
+      a, b, iou, num_threads,
+      [](const RotatedBox3d &first, const RotatedBox3d &second) {
+        return GetIou3d(first, second);
+      });
+}
+
+// Order of the boxes from the highest score to the lowest, ties going to the
+// lower index. The scores are turned into integer keys in the same order and
+// sorted by a stable radix sort, 11 bits at a time, which is several times
+// faster than comparing them.
+std::vector<uint32_t> RankByScore(const std::vector<double> &scores) {
+  constexpr int kDigitBits = 11;
+  constexpr uint64_t kDigitMask = (uint64_t{1} << kDigitBits) - 1;
+  const size_t num_boxes = scores.size();
+  std::vector<uint64_t> keys(num_boxes);
+  std::vector<uint32_t> order(num_boxes);
+  for (uint32_t i = 0; i < num_boxes; ++i) {
+    // -0 and 0 are the same score.
+    const double score = scores[i] == 0 ? 0.0 : scores[i];
+    uint64_t bits;
+    std::memcpy(&bits, &score, sizeof(bits));
+    // Increasing with the score, then inverted for the highest first.
+    bits = bits >> 63 ? ~bits : bits | uint64_t{1} << 63;
+    keys[i] = ~bits;
+    order[i] = i;
+  }
+  std::vector<uint64_t> sorted_keys(num_boxes);
+  std::vector<uint32_t> sorted_order(num_boxes);
+  std::vector<uint32_t> counts(kDigitMask + 2);
+  for (int shift = 0; shift < 64; shift += kDigitBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    for (const uint64_t key : keys) {
+      ++counts[(key >> shift & kDigitMask) + 1];
+    }
+    // Nothing to do when all the keys have the same digit.
+    if (num_boxes == 0 ||
+        counts[(keys[0] >> shift & kDigitMask) + 1] == num_boxes) {
+      continue;
+    }
+    for (size_t digit = 1; digit < counts.size(); ++digit) {
+      counts[digit] += counts[digit - 1];
+    }
+    for (size_t i = 0; i < num_boxes; ++i) {
+      const uint32_t position = counts[keys[i] >> shift & kDigitMask]++;
+      sorted_keys[position] = keys[i];
+      sorted_order[position] = order[i];
+    }
+    keys.swap(sorted_keys);
+    order.swap(sorted_order);
+  }
+  return order;
+}
+
+// Uniform grid over the centers of boxes given in rank order, to find the
+// boxes which may overlap a box with an IoU of at least t, t >= 0. Such boxes
+// a and b have intersecting sides of at least t times the largest of their
+// sides, so their centers are at most (w_a + w_b) / 2 - t * max(w_a, w_b)
+// apart along x. With the largest side of all the boxes W, that is at most
+// (1 - t) * w_a for t >= 1/2, and w_a / 2 + (1/2 - t) * W below. A box only
+// looks at the cells within that reach of its center, and the same along y.
+class BoxGrid {
+ public:
+  // A box in the grid, with its coordinates next to each other.
+  struct Entry {
+    double x_min;
+    double y_min;
+    double x_max;
+    double y_max;
+    double area;
+    uint32_t rank;
+  };
+
+  BoxGrid(const Boxes<double> &boxes, const double min_iou)
+      : min_iou_(std::max(0.0, std::min(min_iou, 1.0))) {
+    const size_t num_boxes = boxes.size();
+    if (num_boxes == 0) {
+      return;
+    }
+    double sum_of_sides = 0.0;
+    double largest_coordinate = 0.0;
+    min_x_ = max_x_ = CenterX(boxes, 0);
+    min_y_ = max_y_ = CenterY(boxes, 0);
+    for (size_t rank = 0; rank < num_boxes; ++rank) {
+      const double side = std::max(boxes.x_max[rank] - boxes.x_min[rank],
+                                   boxes.y_max[rank] - boxes.y_min[rank]);
+      largest_side_ = std::max(largest_side_, side);
+      sum_of_sides += side;
+      largest_coordinate = std::max(
+          {largest_coordinate, std::abs(boxes.x_min[rank]),
+           std::abs(boxes.y_min[rank]), std::abs(boxes.x_max[rank]),
+           std::abs(boxes.y_max[rank])});
+      min_x_ = std::min(min_x_, CenterX(boxes, rank));
+      max_x_ = std::max(max_x_, CenterX(boxes, rank));
+      min_y_ = std::min(min_y_, CenterY(boxes, rank));
+      max_y_ = std::max(max_y_, CenterY(boxes, rank));
+    }
+    // Covers the rounding of the centers and of the IoU.
+    slack_ = 1e-9 * (largest_coordinate + largest_side_);
+    // Cells of half the average side, and at most a few cells per box.
+    const double extent = std::max(max_x_ - min_x_, max_y_ - min_y_);
+    cell_size_ = std::max({0.5 * sum_of_sides / num_boxes,
+                           extent / (2.0 * std::sqrt(num_boxes)), slack_,
+                           1e-300});
+    cols_ = static_cast<int>((max_x_ - min_x_) / cell_size_) + 1;
+    rows_ = static_cast<int>((max_y_ - min_y_) / cell_size_) + 1;
+
+    // Boxes of every cell, counted then filled, in rank order.
+    cell_offsets_.assign(static_cast<size_t>(rows_) * cols_ + 1, 0);
+    std::vector<uint32_t> cells(num_boxes);
+    for (size_t rank = 0; rank < num_boxes; ++rank) {
+      cells[rank] = Cell(Col(CenterX(boxes, rank)), Row(CenterY(boxes, rank)));
+      ++cell_offsets_[cells[rank] + 1];
+    }
+    for (size_t cell = 1; cell < cell_offsets_.size(); ++cell) {
+      cell_offsets_[cell] += cell_offsets_[cell - 1];
+    }
+    cell_boxes_.resize(num_boxes);
+    std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t rank = 0; rank < num_boxes; ++rank) {
+      cell_boxes_[fill[cells[rank]]++] = {
+          boxes.x_min[rank], boxes.y_min[rank], boxes.x_max[rank],
+          boxes.y_max[rank], boxes.area[rank], static_cast<uint32_t>(rank)};
+    }
+    cell_ends_ = std::move(fill);
+  }
+
+  // Calls f(entry) for the boxes left in the grid which may overlap box rank
+  // enough, itself included. The boxes for which f returns false are removed
+  // from the grid.
+  template <typename F>
+  void ForEachCandidate(const Boxes<double> &boxes, const size_t rank, F f) {
+    const double center_x = CenterX(boxes, rank);
+    const double center_y = CenterY(boxes, rank);
+    const double reach_x = Reach(boxes.x_max[rank] - boxes.x_min[rank]);
+    const double reach_y = Reach(boxes.y_max[rank] - boxes.y_min[rank]);
+    const int first_col = Col(center_x - reach_x);
+    const int last_col = Col(center_x + reach_x);
+    const int last_row = Row(center_y + reach_y);
+    for (int row = Row(center_y - reach_y); row <= last_row; ++row) {
+      for (int col = first_col; col <= last_col; ++col) {
+        const uint32_t cell = Cell(col, row);
+        uint32_t end = cell_offsets_[cell];
+        for (uint32_t k = cell_offsets_[cell]; k < cell_ends_[cell]; ++k) {
+          if (f(cell_boxes_[k])) {
+            cell_boxes_[end++] = cell_boxes_[k];
+          }
+        }
+        cell_ends_[cell] = end;
+      }
+    }
+  }
+
+ private:
+  static double CenterX(const Boxes<double> &boxes, const size_t rank) {
+    return 0.5 * (boxes.x_min[rank] + boxes.x_max[rank]);
+  }
+  static double CenterY(const Boxes<double> &boxes, const size_t rank) {
+    return 0.5 * (boxes.y_min[rank] + boxes.y_max[rank]);
+  }
+  // Largest distance between the centers of a box of the given side and of a
+  // box overlapping it enough, along the same axis.
+  double Reach(const double side) const {
+    const double reach =
+        min_iou_ >= 0.5 ? (1.0 - min_iou_) * side
+                        : 0.5 * side + (0.5 - min_iou_) * largest_side_;
+    return reach + slack_;
+  }
+  int Col(const double x) const {
+    return static_cast<int>(std::min(
+        cols_ - 1.0, std::max(0.0, std::floor((x - min_x_) / cell_size_))));
+  }
+  int Row(const double y) const {
+    return static_cast<int>(std::min(
+        rows_ - 1.0, std::max(0.0, std::floor((y - min_y_) / cell_size_))));
+  }
+  uint32_t Cell(const int col, const int row) const {
+    return static_cast<uint32_t>(row) * cols_ + col;
+  }
+
+  double min_iou_;
+  double largest_side_ = 0.0;
+  double slack_ = 0.0;
+  double min_x_ = 0.0;
+  double max_x_ = 0.0;
+  double min_y_ = 0.0;
+  double max_y_ = 0.0;
+  double cell_size_ = 1.0;
+  int rows_ = 0;
+  int cols_ = 0;
+  std::vector<uint32_t> cell_offsets_;
+  std::vector<uint32_t> cell_ends_;  // End of the boxes left in every cell.
+  std::vector<Entry> cell_boxes_;
+};
+
+// IoU of box rank of boxes and a box of the grid, the same as GetIou.
+double GetIou(const Boxes<double> &boxes, const size_t rank,
+              const BoxGrid::Entry &entry) {
+  const double intersecting_length =
+      std::min(boxes.x_max[rank], entry.x_max) -
+      std::max(boxes.x_min[rank], entry.x_min);
+  const double intersecting_breadth =
+      std::min(boxes.y_max[rank], entry.y_max) -
+      std::max(boxes.y_min[rank], entry.y_min);
+  if (intersecting_length < 0 || intersecting_breadth < 0) {
+    return 0;
+  }
+  const double iou_area = intersecting_length * intersecting_breadth;
+  return iou_area / (boxes.area[rank] + entry.area - iou_area);
+}
+
+// Greedy suppression of boxes given in rank order. Returns the ranks of the
+// boxes kept.
+std::vector<uint32_t> NmsRanked(const Boxes<double> &boxes,
+                                const double iou_threshold) {
+  std::vector<uint32_t> kept;
+  if (boxes.size() == 0) {
+    return kept;
+  }
+  // Every IoU is at least 0, the best box suppresses all the others.
+  if (iou_threshold <= 0) {
+    kept.push_back(0);
+    return kept;
+  }
+  // Only the boxes kept suppress others, only their neighbors are tested.
+  // A box kept or suppressed is never a candidate again and leaves the grid.
+  BoxGrid grid(boxes, iou_threshold);
+  std::vector<uint64_t> suppressed((boxes.size() + 63) / 64, 0);
+  for (uint32_t rank = 0; rank < boxes.size(); ++rank) {
+    if (suppressed[rank / 64] >> (rank % 64) & 1) {
+      continue;
+    }
+    kept.push_back(rank);
+    grid.ForEachCandidate(boxes, rank, [&](const BoxGrid::Entry &entry) {
+      // The boxes ranked before have left the grid, the box itself leaves now.
+      const uint32_t other = entry.rank;
+      if (other == rank) {
+        return false;
+      }
+      if (GetIou(boxes, rank, entry) >= iou_threshold) {
+        suppressed[other / 64] |= uint64_t{1} << (other % 64);
+        return false;
+      }
+      return true;
+    });
+  }
+  return kept;
+}
+
+// Non maximum suppression: going from the highest score down, keeps a box
+// unless it overlaps a box already kept with an IoU of iou_threshold or more.
+// Returns the indices of the boxes kept, from the highest score down.
+std::vector<size_t> Nms(const std::vector<Rect> &rects,
+                        const std::vector<double> &scores,
+                        const double iou_threshold) {
+  const std::vector<uint32_t> order = RankByScore(scores);
+  Boxes<double> boxes;
+  boxes.Reserve(order.size());
+  for (const uint32_t index : order) {
+    boxes.Add(rects[index]);
+  }
+  std::vector<size_t> kept;
+  for (const uint32_t rank : NmsRanked(boxes, iou_threshold)) {
+    kept.push_back(order[rank]);
+  }
+  return kept;
+}
+
+// Nms run separately on the boxes of every class, boxes of different classes
+// never suppress each other. Returns the indices of the boxes kept, from the
+// highest score down. Without class ids all the boxes are of one class, and
+// class ids not matching the boxes give no box.
+std::vector<size_t> BatchedNms(const std::vector<Rect> &rects,
+                               const std::vector<double> &scores,
+                               const std::vector<int> &class_ids,
+                               const double iou_threshold) {
+  if (class_ids.empty()) {
+    return Nms(rects, scores, iou_threshold);
+  }
+  if (class_ids.size() != rects.size()) {
+    return {};
+  }
+  // Boxes grouped by class, in rank order within every class. The class ids
+  // usually span a small range and are counted, otherwise sorted.
+  const std::vector<uint32_t> ranking = RankByScore(scores);
+  std::vector<uint32_t> order = ranking;
+  const auto range = std::minmax_element(class_ids.begin(), class_ids.end());
+  const int64_t num_classes = int64_t{*range.second} - *range.first + 1;
+  if (num_classes <= static_cast<int64_t>(2 * class_ids.size() + 64)) {
+    std::vector<uint32_t> counts(num_classes + 1, 0);
+    for (const int class_id : class_ids) {
+      ++counts[class_id - *range.first + 1];
+    }
+    for (int64_t i = 0; i < num_classes; ++i) {
+      counts[i + 1] += counts[i];
+    }
+    for (const uint32_t index : ranking) {
+      order[counts[class_ids[index] - *range.first]++] = index;
+    }
+  } else {
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) {
+                       return class_ids[a] < class_ids[b];
+                     });
+  }
+  std::vector<uint8_t> is_kept(rects.size(), 0);
+  Boxes<double> boxes;
+  for (size_t begin = 0; begin < order.size();) {
+    size_t end = begin;
+    boxes = Boxes<double>();
+    while (end < order.size() &&
+           class_ids[order[end]] == class_ids[order[begin]]) {
+      boxes.Add(rects[order[end++]]);
+    }
+    for (const uint32_t rank : NmsRanked(boxes, iou_threshold)) {
+      is_kept[order[begin + rank]] = 1;
+    }
+    begin = end;
+  }
+  std::vector<size_t> kept;
+  for (const uint32_t index : ranking) {
+    if (is_kept[index]) {
+      kept.push_back(index);
+    }
+  }
+  return kept;
+}
+
+// Pairs of boxes given in rank order with an IoU above 0 and of at least
+// min_iou, found once with a BoxGrid. The neighbors of rank r are
+// [offsets[r], offsets[r + 1]) in neighbors and iou, every pair being listed
+// under both of its boxes.
+struct OverlapGraph {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> neighbors;
+  std::vector<double> iou;
+};
+
+OverlapGraph GetOverlapGraph(const Boxes<double> &boxes,
+                             const double min_iou) {
+  struct Pair {
+    uint32_t first;
+    uint32_t second;
+    double iou;
+  };
+  // Every box leaves the grid after looking for its neighbors, so that each
+  // pair is found by the first of its boxes only.
+  std::vector<Pair> pairs;
+  BoxGrid grid(boxes, min_iou);
+  for (uint32_t rank = 0; rank < boxes.size(); ++rank) {
+    grid.ForEachCandidate(boxes, rank, [&](const BoxGrid::Entry &entry) {
+      if (entry.rank == rank) {
+        return false;
+      }
+      const double iou = GetIou(boxes, rank, entry);
+      if (iou > 0 && iou >= min_iou) {
+        pairs.push_back({rank, entry.rank, iou});
+      }
+      return true;
+    });
+  }
+
+  // Neighbors of every box, counted then filled.
+  OverlapGraph graph;
+  graph.offsets.assign(boxes.size() + 1, 0);
+  for (const auto &pair : pairs) {
+    ++graph.offsets[pair.first + 1];
+    ++graph.offsets[pair.second + 1];
+  }
+  for (size_t rank = 0; rank < boxes.size(); ++rank) {
+    graph.offsets[rank + 1] += graph.offsets[rank];
+  }
+  graph.neighbors.resize(2 * pairs.size());
+  graph.iou.resize(2 * pairs.size());
+  std::vector<uint32_t> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+  for (const auto &pair : pairs) {
+    graph.neighbors[fill[pair.first]] = pair.second;
+    graph.iou[fill[pair.first]++] = pair.iou;
+    graph.neighbors[fill[pair.second]] = pair.first;
+    graph.iou[fill[pair.second]++] = pair.iou;
+  }
+  return graph;
+}
+
+enum class SoftNmsDecay {
+  // Scores of boxes with an IoU of iou_threshold or more multiplied by
+  // 1 - IoU.
+  kLinear,
+  // Scores multiplied by exp(-IoU^2 / sigma).
+  kGaussian,
+};
+
+struct SoftNmsOptions {
+  SoftNmsDecay decay = SoftNmsDecay::kGaussian;
+  double iou_threshold = 0.3;
+  double sigma = 0.5;
+  // Boxes whose score decays below it are dropped.
+  double score_threshold = 0.001;
+};
+
+// Soft-NMS (N. Bodla et al., "Soft-NMS -- Improving Object Detection With One
+// Line of Code", 2017): instead of suppressing the boxes overlapping the box
+// with the highest score, their scores decay with their IoU, and the highest
+// score is picked again among the others. The IoUs come from the overlap
+// graph computed once, and the decayed scores from a heap, so every pick only
+// updates the neighbors of the box picked.
+// Returns the indices of the boxes kept in the order they were picked, with
+// their decayed scores in kept_scores.
+std::vector<size_t> SoftNms(const std::vector<Rect> &rects,
+                            const std::vector<double> &scores,
+                            const SoftNmsOptions &options,
+                            std::vector<double> *kept_scores) {
+  const std::vector<uint32_t> order = RankByScore(scores);
+  Boxes<double> boxes;
+  boxes.Reserve(order.size());
+  std::vector<double> current(order.size());
+  for (size_t rank = 0; rank < order.size(); ++rank) {
+    boxes.Add(rects[order[rank]]);
+    current[rank] = scores[order[rank]];
+  }
+  // The linear decay leaves the boxes under its threshold untouched.
+  const OverlapGraph graph = GetOverlapGraph(
+      boxes,
+      options.decay == SoftNmsDecay::kLinear ? options.iou_threshold : 0.0);
+
+  // Highest score first, ties going to the lower rank. Every box left has
+  // one entry in the heap, with its score when it was pushed. Scores only
+  // decay, a box whose score decayed since is pushed again when it comes out
+  // on top.
+  using Entry = std::pair<double, uint32_t>;
+  auto lower = [](const Entry &a, const Entry &b) {
+    return a.first < b.first || (a.first == b.first && a.second > b.second);
+  };
+  std::vector<Entry> heap;
+  for (uint32_t rank = 0; rank < order.size(); ++rank) {
+    heap.emplace_back(current[rank], rank);
+  }
+  std::make_heap(heap.begin(), heap.end(), lower);
+  std::vector<uint8_t> done(order.size(), 0);
+
+  std::vector<size_t> kept;
+  kept_scores->clear();
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), lower);
+    const Entry top = heap.back();
+    heap.pop_back();
+    const uint32_t rank = top.second;
+    if (top.first != current[rank]) {
+      heap.emplace_back(current[rank], rank);
+      std::push_heap(heap.begin(), heap.end(), lower);
+      continue;
+    }
+    // Every box left has a lower score.
+    if (top.first < options.score_threshold) {
+      break;
+    }
+    done[rank] = 1;
+    kept.push_back(order[rank]);
+    kept_scores->push_back(top.first);
+    for (uint32_t k = graph.offsets[rank]; k < graph.offsets[rank + 1]; ++k) {
+      const uint32_t other = graph.neighbors[k];
+      if (done[other]) {
+        continue;
+      }
+      const double iou = graph.iou[k];
+      current[other] *= options.decay == SoftNmsDecay::kLinear
+                            ? 1.0 - iou
+                            : std::exp(-iou * iou / options.sigma);
+    }
+  }
+  return kept;
+}
+
+// Weighted box fusion (R. Solovyev et al., "Weighted boxes fusion: Ensembling
+// boxes from different object detection models", 2021) of the boxes of one
+// detector: going from the highest score down, a box joins the cluster whose
+// fused box it overlaps with the largest IoU above iou_threshold, or starts a
+// new one. The fused box is the average of the boxes of its cluster weighted
+// by their scores, and its score the average of their scores. A box is only
+// compared with the fused boxes of the clusters holding a box it overlaps,
+// taken from the overlap graph.
+// Returns the fused boxes from the highest score down, with their scores in
+// fused_scores.
+std::vector<Rect> WeightedBoxFusion(const std::vector<Rect> &rects,
+                                    const std::vector<double> &scores,
+                                    const double iou_threshold,
+                                    std::vector<double> *fused_scores) {
+  const std::vector<uint32_t> order = RankByScore(scores);
+  Boxes<double> boxes;
+  boxes.Reserve(order.size());
+  for (const uint32_t index : order) {
+    boxes.Add(rects[index]);
+  }
+  const OverlapGraph graph = GetOverlapGraph(boxes, 0.0);
+
+  struct Cluster {
+    // Sums of the corners weighted by the scores, and of the scores.
+    double x_min = 0.0;
+    double y_min = 0.0;
+    double x_max = 0.0;
+    double y_max = 0.0;
+    double score = 0.0;
+    int num_boxes = 0;
+    Rect fused{0.0, 0.0, 0.0, 0.0};
+    uint32_t last_tested = 0;  // Rank of the last box compared with it.
+  };
+  std::vector<Cluster> clusters;
+  std::vector<uint32_t> cluster_of(order.size());
+  for (uint32_t rank = 0; rank < order.size(); ++rank) {
+    const Rect &rect = rects[order[rank]];
+    uint32_t best_cluster = 0;
+    double best_iou = iou_threshold;
+    bool found = false;
+    for (uint32_t k = graph.offsets[rank]; k < graph.offsets[rank + 1]; ++k) {
+      const uint32_t other = graph.neighbors[k];
+      if (other > rank) {
+        continue;
+      }
+      const uint32_t id = cluster_of[other];
+      Cluster &cluster = clusters[id];
+      if (cluster.last_tested == rank + 1) {
+        continue;
+      }
+      cluster.last_tested = rank + 1;
+      // The first cluster wins a tie.
+      const double iou = GetIou(cluster.fused, rect);
+      if (iou > best_iou || (found && iou == best_iou && id < best_cluster)) {
+        best_cluster = id;
+        best_iou = iou;
+        found = true;
+      }
+    }
+    if (!found) {
+      best_cluster = static_cast<uint32_t>(clusters.size());
+      clusters.emplace_back();
+    }
+    cluster_of[rank] = best_cluster;
+    Cluster &cluster = clusters[best_cluster];
+    const double score = scores[order[rank]];
+    cluster.x_min += score * boxes.x_min[rank];
+    cluster.y_min += score * boxes.y_min[rank];
+    cluster.x_max += score * boxes.x_max[rank];
+    cluster.y_max += score * boxes.y_max[rank];
+    cluster.score += score;
+    ++cluster.num_boxes;
+    const double x_min = cluster.x_min / cluster.score;
+    const double y_min = cluster.y_min / cluster.score;
+    cluster.fused = {x_min, y_min, cluster.x_max / cluster.score - x_min,
+                     cluster.y_max / cluster.score - y_min};
+  }
+
+  std::vector<uint32_t> ranking(clusters.size());
+  for (uint32_t id = 0; id < clusters.size(); ++id) {
+    ranking[id] = id;
+  }
+  std::stable_sort(ranking.begin(), ranking.end(),
+                   [&](const uint32_t a, const uint32_t b) {
+                     return clusters[a].score / clusters[a].num_boxes >
+                            clusters[b].score / clusters[b].num_boxes;
+                   });
+  std::vector<Rect> fused;
+  fused_scores->clear();
+  for (const uint32_t id : ranking) {
+    fused.push_back(clusters[id].fused);
+    fused_scores->push_back(clusters[id].score / clusters[id].num_boxes);
+  }
+  return fused;
+}
+
 int main() {
 
   Rect b{2, 2, 1, 1};
   Rect a{1.5, 1.5, 1, 1};
   auto iou = GetIou(a, b);
   std::cout << iou << std::endl;
+
+  // IoU of every detection against every track, against calling GetIou on
+  // every pair.
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::uniform_real_distribution<double> size(5.0, 50.0);
+  auto random_rects = [&](const size_t count) {
+    std::vector<Rect> rects(count);
+    for (auto &rect : rects) {
+      rect = {position(generator), position(generator), size(generator),
+              size(generator)};
+    }
+    return rects;
+  };
+  const std::vector<Rect> detections = random_rects(2000);
+  const std::vector<Rect> tracks = random_rects(3000);
+
+  std::vector<double> expected(detections.size() * tracks.size());
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < detections.size(); ++i) {
+    for (size_t j = 0; j < tracks.size(); ++j) {
+      expected[i * tracks.size() + j] = GetIou(detections[i], tracks[j]);
+    }
+  }
+  const double loop_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  std::cout << detections.size() << " x " << tracks.size()
+            << " IoU matrix, GetIou on every pair: " << loop_ms << " ms"
+            << std::endl;
+
+  auto benchmark = [&](const auto &detection_boxes, const auto &track_boxes,
+                       const char *name) {
+    using T = typename std::decay_t<decltype(detection_boxes.area)>::value_type;
+    // The matrix is reused from frame to frame, only the second call is
+    // timed.
+    std::vector<T> matrix;
+    GetIouMatrix(detection_boxes, track_boxes, &matrix);
+    const auto matrix_start = std::chrono::steady_clock::now();
+    GetIouMatrix(detection_boxes, track_boxes, &matrix);
+    const double matrix_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() -
+                                 matrix_start)
+                                 .count();
+    double max_difference = 0.0;
+    for (size_t k = 0; k < matrix.size(); ++k) {
+      max_difference =
+          std::max(max_difference, std::abs(matrix[k] - expected[k]));
+    }
+    std::cout << "GetIouMatrix (" << name << "): " << matrix_ms
+              << " ms, largest difference " << max_difference << std::endl;
+  };
+  benchmark(Boxes<double>(detections), Boxes<double>(tracks), "double");
+  benchmark(Boxes<float>(detections), Boxes<float>(tracks), "float");
+
+  // Non maximum suppression, the boxes of NMS/nms.py.
+  const std::vector<Rect> candidates{
+      {1, 1, 2, 2}, {1, 1, 2, 3}, {1, 0.9, 2.6, 2.1}, {1, 0.9, 2.5, 2.1}};
+  const std::vector<double> candidate_scores{0.95, 0.93, 0.98, 0.97};
+  std::cout << "Boxes kept:";
+  for (const size_t index : Nms(candidates, candidate_scores, 0.5)) {
+    std::cout << " " << index;
+  }
+  std::cout << std::endl;
+
+  // Detector output, many candidates around every object.
+  std::uniform_real_distribution<double> jitter(-3.0, 3.0);
+  std::uniform_real_distribution<double> score(0.0, 1.0);
+  std::uniform_int_distribution<int> class_id(0, 9);
+  const std::vector<Rect> objects = random_rects(1000);
+  std::vector<Rect> rects;
+  std::vector<double> scores;
+  std::vector<int> class_ids;
+  for (const auto &object : objects) {
+    for (int i = 0; i < 10; ++i) {
+      rects.push_back({object.x + jitter(generator),
+                       object.y + jitter(generator),
+                       object.length + jitter(generator),
+                       object.breadth + jitter(generator)});
+      scores.push_back(score(generator));
+      class_ids.push_back(class_id(generator));
+    }
+  }
+  // Suppression against every box kept so far, for comparison.
+  auto nms_every_pair = [&](const bool by_class) {
+    const std::vector<uint32_t> order = RankByScore(scores);
+    std::vector<size_t> kept;
+    for (const uint32_t index : order) {
+      bool suppressed = false;
+      for (const size_t other : kept) {
+        if ((!by_class || class_ids[index] == class_ids[other]) &&
+            GetIou(rects[other], rects[index]) >= 0.5) {
+          suppressed = true;
+          break;
+        }
+      }
+      if (!suppressed) {
+        kept.push_back(index);
+      }
+    }
+    return kept;
+  };
+  auto time_ms = [](const auto &f) {
+    f();
+    const auto time_start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - time_start)
+        .count();
+  };
+  std::vector<size_t> kept;
+  const double nms_ms =
+      time_ms([&] { kept = Nms(rects, scores, 0.5); });
+  const double every_pair_ms = time_ms([&] { nms_every_pair(false); });
+  std::cout << "Nms of " << rects.size() << " boxes: " << kept.size()
+            << " kept in " << nms_ms << " ms against " << every_pair_ms
+            << " ms testing every kept box, "
+            << (kept == nms_every_pair(false) ? "same" : "different")
+            << " result" << std::endl;
+  const double batched_ms =
+      time_ms([&] { kept = BatchedNms(rects, scores, class_ids, 0.5); });
+  std::cout << "BatchedNms of " << rects.size() << " boxes in 10 classes: "
+            << kept.size() << " kept in " << batched_ms << " ms, "
+            << (kept == nms_every_pair(true) ? "same" : "different")
+            << " result" << std::endl;
+  std::cout << "BatchedNms without class ids: "
+            << (BatchedNms(rects, scores, {}, 0.5) == Nms(rects, scores, 0.5)
+                    ? "same"
+                    : "different")
+            << " result as Nms" << std::endl;
+
+  std::vector<double> kept_scores;
+  SoftNmsOptions options;
+  const double soft_nms_ms =
+      time_ms([&] { kept = SoftNms(rects, scores, options, &kept_scores); });
+  std::cout << "SoftNms (gaussian) of " << rects.size() << " boxes: "
+            << kept.size() << " kept in " << soft_nms_ms << " ms"
+            << std::endl;
+  options.decay = SoftNmsDecay::kLinear;
+  const double linear_ms =
+      time_ms([&] { kept = SoftNms(rects, scores, options, &kept_scores); });
+  std::cout << "SoftNms (linear) of " << rects.size() << " boxes: "
+            << kept.size() << " kept in " << linear_ms << " ms" << std::endl;
+  std::vector<Rect> fused;
+  std::vector<double> fused_scores;
+  const double fusion_ms = time_ms(
+      [&] { fused = WeightedBoxFusion(rects, scores, 0.55, &fused_scores); });
+  std::cout << "WeightedBoxFusion of " << rects.size() << " boxes: "
+            << fused.size() << " fused boxes in " << fusion_ms << " ms"
+            << std::endl;
+
+  // Rotated boxes in bird's eye view and 3D boxes, e.g. cars around a lidar.
+  std::uniform_real_distribution<double> ground(-100.0, 100.0);
+  std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+  auto random_cars = [&](const size_t count) {
+    std::vector<Box3d> cars(count);
+    for (auto &car : cars) {
+      car = {ground(generator),
+             ground(generator),
+             0.8 + 0.1 * jitter(generator),
+             4.5 + 0.2 * jitter(generator),
+             1.8 + 0.1 * jitter(generator),
+             1.6 + 0.1 * jitter(generator),
+             heading(generator)};
+    }
+    return cars;
+  };
+  const std::vector<Box3d> cars = random_cars(2000);
+  const std::vector<Box3d> car_tracks = random_cars(2000);
+  std::vector<RotatedRect> footprints;
+  std::vector<RotatedRect> track_footprints;
+  for (const auto &car : cars) {
+    footprints.push_back(
+        {car.center_x, car.center_y, car.length, car.breadth, car.yaw});
+  }
+  for (const auto &car : car_tracks) {
+    track_footprints.push_back(
+        {car.center_x, car.center_y, car.length, car.breadth, car.yaw});
+  }
+  std::vector<double> rotated_iou(cars.size() * car_tracks.size());
+  const double rotated_loop_ms = time_ms([&] {
+    for (size_t i = 0; i < footprints.size(); ++i) {
+      for (size_t j = 0; j < track_footprints.size(); ++j) {
+        rotated_iou[i * track_footprints.size() + j] =
+            GetRotatedIou(footprints[i], track_footprints[j]);
+      }
+    }
+  });
+  std::vector<double> rotated_matrix;
+  const double rotated_matrix_ms = time_ms([&] {
+    GetRotatedIouMatrix(footprints, track_footprints, &rotated_matrix);
+  });
+  std::cout << cars.size() << " x " << car_tracks.size()
+            << " rotated IoU matrix: " << rotated_matrix_ms << " ms against "
+            << rotated_loop_ms << " ms calling GetRotatedIou on every pair, "
+            << (rotated_matrix == rotated_iou ? "same" : "different")
+            << " result" << std::endl;
+  std::vector<double> iou_3d;
+  const double matrix_3d_ms =
+      time_ms([&] { GetIou3dMatrix(cars, car_tracks, &iou_3d); });
+  const size_t num_overlaps =
+      iou_3d.size() - std::count(iou_3d.begin(), iou_3d.end(), 0.0);
+  std::cout << cars.size() << " x " << car_tracks.size()
+            << " 3D IoU matrix: " << matrix_3d_ms << " ms, " << num_overlaps
+            << " overlapping pairs" << std::endl;
   return 0;
 }
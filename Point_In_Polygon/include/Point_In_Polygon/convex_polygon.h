@@ -0,0 +1,71 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Check if a Point is Inside, On or Outside a convex polygon in
+ *        O(log n), and detect the polygons which are convex.
+ *
+ */
+#ifndef POINT_IN_POLYGON_CONVEX_POLYGON_H_
+#define POINT_IN_POLYGON_CONVEX_POLYGON_H_
+
+#include <Eigen/Dense>
+#include <vector>
+
+/**
+ * @brief Check if a polygon is convex: every turn along its sides goes the
+ *        same way, and its sides go around only once. Collinear and repeated
+ *        vertices are allowed, a polygon with all its vertices on a line is
+ *        not convex.
+ *
+ * @param polygon Vertices making up the polygon, in either direction.
+ * @return true if the polygon is convex.
+ */
+bool is_convex_polygon(const std::vector<Eigen::Vector2d> &polygon);
+
+/**
+ * @brief Convex polygon split into a fan of triangles around its first
+ *        vertex.
+ *
+ * The diagonals from the first vertex split the plane around it into wedges.
+ * A query finds the wedge of the point by binary search on the side of the
+ * diagonals it lies on, then tests it against the single side of the polygon
+ * closing that wedge.
+ *
+ */
+class ConvexPolygon {
+   public:
+    /**
+     * @brief Prepare the fan of the polygon.
+     *
+     * @param vertices Vertices making up the polygon, in either direction.
+     *        The polygon must be convex, see is_convex_polygon.
+     */
+    explicit ConvexPolygon(const std::vector<Eigen::Vector2d> &vertices);
+
+    /**
+     * @brief Check if a point lies inside, on or outside the polygon, in
+     *        O(log n) for n vertices.
+     *
+     * @param query_point Point to check.
+     * @return  = 1: query_point lies inside the polygon.
+     *          = 0: query_point lies on the polygon.
+     *          =-1: query_point lies outside the polygon.
+     */
+    int is_point_inside(const Eigen::Vector2d &query_point) const;
+
+    /**
+     * @brief Vertices of the polygon in anticlockwise direction, without the
+     *        repeated and collinear ones.
+     *
+     */
+    const std::vector<Eigen::Vector2d> &vertices() const { return vertices_; }
+
+   private:
+    std::vector<Eigen::Vector2d> vertices_;
+};
+
+#endif  // POINT_IN_POLYGON_CONVEX_POLYGON_H_
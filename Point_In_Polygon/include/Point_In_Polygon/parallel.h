@@ -0,0 +1,53 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Split a batch of queries across threads.
+ *
+ */
+#ifndef POINT_IN_POLYGON_PARALLEL_H_
+#define POINT_IN_POLYGON_PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Call f(begin, end) on contiguous ranges covering [0, size), each on
+ *        its own thread. The calling thread takes the last range.
+ *
+ * @param size Number of items.
+ * @param num_threads Number of threads, 0 for all the hardware threads.
+ * @param min_chunk Smallest number of items given to a thread, so that small
+ *        batches are not slowed down by starting threads.
+ * @param f Function called with the range of every thread.
+ */
+template <typename F>
+void parallel_for(const size_t size, const int num_threads,
+                  const size_t min_chunk, F f) {
+    const size_t max_threads =
+        num_threads > 0 ? static_cast<size_t>(num_threads)
+                        : std::max(1u, std::thread::hardware_concurrency());
+    const size_t num_chunks = std::max<size_t>(
+        1, std::min(max_threads, size / std::max<size_t>(1, min_chunk)));
+    if (num_chunks == 1) {
+        f(size_t{0}, size);
+        return;
+    }
+    const size_t chunk_size = (size + num_chunks - 1) / num_chunks;
+    std::vector<std::thread> threads;
+    threads.reserve(num_chunks - 1);
+    for (size_t chunk = 0; chunk + 1 < num_chunks; ++chunk) {
+        threads.emplace_back(f, chunk * chunk_size, (chunk + 1) * chunk_size);
+    }
+    f((num_chunks - 1) * chunk_size, size);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+#endif  // POINT_IN_POLYGON_PARALLEL_H_
@@ -0,0 +1,132 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Check if a Point is Inside , On or Outside a given Polygon, one point
+ *        at a time or for a whole batch of points.
+ *
+ */
+#ifndef POINT_IN_POLYGON_POINT_IN_POLYGON_H_
+#define POINT_IN_POLYGON_POINT_IN_POLYGON_H_
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Point_In_Polygon/convex_polygon.h"
+
+/**
+ * @brief The result can be used to test if the query point lies on the left or
+ *        right side of the line formed by pt1 and pt2 when viewed in
+ *        anticlockwise  direction.
+ *
+ * @param pt1: First point to form equation of line.
+ * @param pt2: Second point to form equation of line.
+ * @param query_point: Query point
+ * @return: > 0: Query point lies on left of the line.
+ *          = 0: Query point lies on the line.
+ *          < 0: Query point lies on right of the line.
+ *          The sign is exact, a point is on the line only when it exactly is,
+ *          see robust_predicates.h.
+ */
+double substitute_point_in_line(const Eigen::Vector2d &pt1,
+                                const Eigen::Vector2d &pt2,
+                                const Eigen::Vector2d &query_point);
+
+/**
+ * @brief Check if a point lies within the bounding box of a segment. For a
+ *        point on the line through the segment, it tells if the point lies on
+ *        the segment itself.
+ *
+ */
+bool is_point_within_segment_bounds(const Eigen::Vector2d &pt1,
+                                    const Eigen::Vector2d &pt2,
+                                    const Eigen::Vector2d &query_point);
+
+/**
+ * @brief Check if a point lies inside, on or outside a convex polygon.
+ *
+ * Tests every side, O(n) for n vertices. Preparing the O(log n) search of
+ * ConvexPolygon costs O(n) too, so it only pays off when several points are
+ * tested against the same polygon.
+ *
+ * @param query_point Point to check.
+ * @param vertices Vertices making up the polygon.
+ * @return  = 1: query_point lies inside the polygon.
+ *          = 0: query_point lies on the polygon.
+ *          =-1: query_point lies outside the polygon.
+ */
+int is_point_inside_convex_polygon(
+    const Eigen::Vector2d &query_point,
+    const std::vector<Eigen::Vector2d> &vertices);
+
+/**
+ * @brief Check if a point lies inside, on or outside any polygon using the
+ *        winding number algorithm.
+ *
+ * @param query_point Point to check.
+ * @param vertices Vertices making up the polygon in anticlockwise direction.
+ * @return  = 1: query_point lies inside the polygon.
+ *          = 0: query_point lies on the polygon.
+ *          =-1: query_point lies outside the polygon.
+ */
+int is_point_inside_polygon(const Eigen::Vector2d &query_point,
+                            const std::vector<Eigen::Vector2d> &vertices);
+
+/**
+ * @brief Edges of a polygon as separate arrays, computed once and shared by
+ *        all the query points. Edge i goes from vertex i to vertex i + 1, the
+ *        last one back to the first vertex. A convex polygon with enough
+ *        vertices for its binary search to beat testing every edge also gets
+ *        its ConvexPolygon.
+ *
+ */
+struct PolygonEdges {
+    explicit PolygonEdges(const std::vector<Eigen::Vector2d> &vertices);
+
+    size_t size() const { return x1.size(); }
+
+    std::vector<double> x1;  // Start of the edge.
+    std::vector<double> y1;
+    std::vector<double> x2;  // End of the edge.
+    std::vector<double> y2;
+    std::vector<double> dx;  // End minus start.
+    std::vector<double> dy;
+    std::optional<ConvexPolygon> convex;
+};
+
+/**
+ * @brief Check if a batch of points lie inside, on or outside any polygon.
+ *
+ * Gives the same results as is_point_inside_polygon for every point. The
+ * points are given as separate x and y arrays so that 4 points are tested
+ * against an edge per instruction when built with AVX2, and the batch is
+ * split across threads.
+ *
+ * @param xs x coordinates of the points.
+ * @param ys y coordinates of the points.
+ * @param num_points Number of points.
+ * @param vertices Vertices making up the polygon in anticlockwise direction.
+ * @param results num_points results, 1 inside, 0 on and -1 outside.
+ * @param num_threads Number of threads, 0 for all the hardware threads.
+ */
+void are_points_inside_polygon(const double *xs, const double *ys,
+                               size_t num_points,
+                               const std::vector<Eigen::Vector2d> &vertices,
+                               int8_t *results, int num_threads = 0);
+
+/**
+ * @brief Same as above with the edges of the polygon already computed, when
+ *        several batches are tested against the same polygon.
+ *
+ */
+void are_points_inside_polygon(const double *xs, const double *ys,
+                               size_t num_points, const PolygonEdges &edges,
+                               int8_t *results, int num_threads = 0);
+
+#endif  // POINT_IN_POLYGON_POINT_IN_POLYGON_H_
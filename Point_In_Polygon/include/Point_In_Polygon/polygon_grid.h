@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Walks of the edges of a polygon over a uniform grid of cells, row 0
+ *        at the bottom and column 0 on the left, shared by PolygonIndex and
+ *        rasterize_polygon.
+ *
+ */
+#ifndef POINT_IN_POLYGON_POLYGON_GRID_H_
+#define POINT_IN_POLYGON_POLYGON_GRID_H_
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief x coordinate of the edge from pt1 to pt2 at height y. The edge must
+ *        not be horizontal.
+ *
+ */
+inline double edge_x_at(const Eigen::Vector2d &pt1, const Eigen::Vector2d &pt2,
+                        const double y) {
+    return pt1.x() + (y - pt1.y()) * (pt2.x() - pt1.x()) / (pt2.y() - pt1.y());
+}
+
+/**
+ * @brief Contribution of the edge from pt1 to pt2 to the winding number of
+ *        the points of the horizontal line at height y left of the edge, with
+ *        the same half open rule as is_point_inside_polygon.
+ *
+ * @return  = 1: the edge crosses the line upward.
+ *          =-1: the edge crosses the line downward.
+ *          = 0: the edge does not cross the line.
+ */
+inline int edge_crossing_at(const Eigen::Vector2d &pt1,
+                            const Eigen::Vector2d &pt2, const double y) {
+    if (pt1.y() <= y && pt2.y() > y) {
+        return 1;
+    }
+    if (pt1.y() > y && pt2.y() <= y) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Index of the cell along an axis, clamped to [-1, num_cells], such
+ *        that coordinate lies in the cell or at its lower end.
+ *
+ * @param offset Coordinate relative to the start of the grid, in cells.
+ */
+inline int clamped_cell(const double offset, const int num_cells) {
+    return static_cast<int>(std::max(
+        -1.0, std::min(static_cast<double>(num_cells), std::floor(offset))));
+}
+
+/**
+ * @brief Call f(row, y) for every row of the grid whose line of centers, at
+ *        height y, meets the edge from pt1 to pt2, ends included.
+ *
+ * @param origin Bottom left corner of the grid.
+ * @param cell_size Width and height of the cells.
+ */
+template <typename F>
+void for_each_center_row_of_edge(const Eigen::Vector2d &pt1,
+                                 const Eigen::Vector2d &pt2,
+                                 const Eigen::Vector2d &origin,
+                                 const Eigen::Vector2d &cell_size,
+                                 const int rows, F f) {
+    const double y_min = std::min(pt1.y(), pt2.y());
+    const double y_max = std::max(pt1.y(), pt2.y());
+    // One row more on each side covers the rounding of the division.
+    const int first_row = std::max(
+        0, clamped_cell((y_min - origin.y()) / cell_size.y() - 1.0, rows));
+    const int last_row = std::min(
+        rows - 1,
+        clamped_cell((y_max - origin.y()) / cell_size.y() + 1.0, rows));
+    for (int row = first_row; row <= last_row; ++row) {
+        const double y = origin.y() + (row + 0.5) * cell_size.y();
+        if (y_min <= y && y <= y_max) {
+            f(row, y);
+        }
+    }
+}
+
+/**
+ * @brief Call f(row, col) for every cell of the grid touched by the edge from
+ *        pt1 to pt2, a row at a time along the edge.
+ *
+ * @param origin Bottom left corner of the grid.
+ * @param cell_size Width and height of the cells.
+ * @param margin Distance by which the edge is widened on every side, for the
+ *        rounding of the edge and of the points tested against it.
+ */
+template <typename F>
+void for_each_cell_touched_by_edge(const Eigen::Vector2d &pt1,
+                                   const Eigen::Vector2d &pt2,
+                                   const Eigen::Vector2d &origin,
+                                   const Eigen::Vector2d &cell_size,
+                                   const int rows, const int cols,
+                                   const double margin, F f) {
+    const double y_min = std::min(pt1.y(), pt2.y());
+    const double y_max = std::max(pt1.y(), pt2.y());
+    const int first_row = std::max(
+        0, clamped_cell((y_min - margin - origin.y()) / cell_size.y(), rows));
+    const int last_row = std::min(
+        rows - 1,
+        clamped_cell((y_max + margin - origin.y()) / cell_size.y(), rows));
+    for (int row = first_row; row <= last_row; ++row) {
+        // Part of the edge within the row.
+        double x_min = std::min(pt1.x(), pt2.x());
+        double x_max = std::max(pt1.x(), pt2.x());
+        if (pt1.y() != pt2.y()) {
+            const double bottom = origin.y() + row * cell_size.y();
+            const double x_bottom = edge_x_at(
+                pt1, pt2, std::max(y_min, std::min(y_max, bottom)));
+            const double x_top = edge_x_at(
+                pt1, pt2,
+                std::max(y_min, std::min(y_max, bottom + cell_size.y())));
+            x_min = std::max(x_min, std::min(x_bottom, x_top));
+            x_max = std::min(x_max, std::max(x_bottom, x_top));
+        }
+        const int first_col = std::max(
+            0,
+            clamped_cell((x_min - margin - origin.x()) / cell_size.x(), cols));
+        const int last_col = std::min(
+            cols - 1,
+            clamped_cell((x_max + margin - origin.x()) / cell_size.x(), cols));
+        for (int col = first_col; col <= last_col; ++col) {
+            f(row, col);
+        }
+    }
+}
+
+#endif  // POINT_IN_POLYGON_POLYGON_GRID_H_
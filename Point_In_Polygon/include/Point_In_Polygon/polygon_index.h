@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Index over the edges of a polygon, built once, so that a query only
+ *        tests the few edges around the query point instead of all of them.
+ *
+ */
+#ifndef POINT_IN_POLYGON_POLYGON_INDEX_H_
+#define POINT_IN_POLYGON_POLYGON_INDEX_H_
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Point_In_Polygon/convex_polygon.h"
+
+/**
+ * @brief Uniform grid over the bounding box of a polygon.
+ *
+ * Every cell is either fully inside, fully outside or crossed by the boundary
+ * of the polygon. A cell crossed by the boundary keeps the list of the edges
+ * touching it and the winding number at its center. The winding number of a
+ * query point is then the one of the center plus the crossings of the edges
+ * of the cell along the path from the center to the point, first vertical
+ * then horizontal. With about one cell per edge, a query tests a handful of
+ * edges whatever the size of the polygon.
+ *
+ * Convex polygons with few vertices are answered by ConvexPolygon instead,
+ * whose binary search is then faster than the grid.
+ *
+ */
+class PolygonIndex {
+   public:
+    /**
+     * @brief Build the index of a polygon.
+     *
+     * @param vertices Vertices making up the polygon in anticlockwise
+     *        direction.
+     * @param cells_per_edge Number of cells of the grid per edge of the
+     *        polygon. More cells means fewer edges per cell.
+     */
+    explicit PolygonIndex(const std::vector<Eigen::Vector2d> &vertices,
+                          double cells_per_edge = 2.0);
+
+    /**
+     * @brief Check if a point lies inside, on or outside the polygon. Same
+     *        result as is_point_inside_polygon.
+     *
+     * @param query_point Point to check.
+     * @return  = 1: query_point lies inside the polygon.
+     *          = 0: query_point lies on the polygon.
+     *          =-1: query_point lies outside the polygon.
+     */
+    int is_point_inside(const Eigen::Vector2d &query_point) const;
+
+    // Size of the grid, 0 when the polygon is answered by ConvexPolygon.
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+   private:
+    // State of a cell.
+    enum CellState : int8_t { kOutside = -1, kBoundary = 0, kInside = 1 };
+    // Winding number of a cell whose center lies on the polygon.
+    static constexpr int32_t kCenterOnPolygon = INT32_MIN;
+
+    int cell_row(double y) const;
+    int cell_col(double x) const;
+    Eigen::Vector2d cell_center(int row, int col) const;
+    /**
+     * @brief Last vertex of an edge, edge i going from vertex i to vertex
+     *        i + 1 and the last edge back to the first vertex.
+     *
+     */
+    const Eigen::Vector2d &edge_end(size_t edge) const;
+    /**
+     * @brief Call f(cell) for every cell touched by the edge, with a margin
+     *        for the rounding of the edge and of the query points.
+     *
+     */
+    template <typename F>
+    void for_each_cell_of_edge(size_t edge, F f) const;
+    /**
+     * @brief Winding number at the centers of the cells, sweeping every row
+     *        of centers from left to right.
+     *
+     */
+    void compute_center_winding_numbers();
+
+    // Vertices of the polygon, kept for the queries the grid cannot answer.
+    std::vector<Eigen::Vector2d> vertices_;
+    // Fan of a small convex polygon, used instead of the grid.
+    std::optional<ConvexPolygon> convex_;
+    Eigen::Vector2d min_;
+    Eigen::Vector2d max_;
+    Eigen::Vector2d cell_size_;
+    double margin_ = 0.0;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<int8_t> cell_state_;
+    std::vector<int32_t> center_wn_;
+    // Edges of cell c are cell_edges_[cell_offsets_[c], cell_offsets_[c + 1]).
+    std::vector<uint32_t> cell_offsets_;
+    std::vector<uint32_t> cell_edges_;
+};
+
+#endif  // POINT_IN_POLYGON_POLYGON_INDEX_H_
@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Find which of many polygons contain a point, testing only the
+ *        polygons whose bounding box holds it.
+ *
+ */
+#ifndef POINT_IN_POLYGON_POLYGON_RTREE_H_
+#define POINT_IN_POLYGON_POLYGON_RTREE_H_
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Point_In_Polygon/convex_polygon.h"
+
+/**
+ * @brief R-tree over the bounding boxes of a set of polygons, bulk loaded
+ *        with Sort-Tile-Recursive packing.
+ *
+ * The boxes are sorted along x into vertical slices, every slice along y,
+ * and packed in order into nodes of node_capacity boxes. The nodes are
+ * packed the same way until a single root is left. All the nodes are full
+ * but the last one of every slice, and the tree is stored in flat arrays,
+ * a level after the other.
+ *
+ * A point is contained by a polygon when is_point_inside_polygon says it
+ * lies inside or on the polygon. Convex polygons are tested in O(log n)
+ * with ConvexPolygon instead.
+ *
+ */
+class PolygonRTree {
+   public:
+    /**
+     * @brief Build the tree.
+     *
+     * @param polygons Vertices of every polygon in anticlockwise direction.
+     * @param node_capacity Maximum number of children of a node, from 2 to
+     *        64.
+     */
+    explicit PolygonRTree(
+        const std::vector<std::vector<Eigen::Vector2d>> &polygons,
+        int node_capacity = 16);
+
+    /**
+     * @brief Find the first polygon, in the order given to the constructor,
+     *        containing a point.
+     *
+     * @param query_point Point to look up.
+     * @return Index of the polygon, -1 when no polygon contains the point.
+     */
+    int32_t find_polygon(const Eigen::Vector2d &query_point) const;
+
+    /**
+     * @brief Find all the polygons containing a point.
+     *
+     * @param query_point Point to look up.
+     * @param polygon_ids Indices of the polygons, in increasing order.
+     */
+    void find_polygons(const Eigen::Vector2d &query_point,
+                       std::vector<int32_t> *polygon_ids) const;
+
+    /**
+     * @brief Find the first polygon containing every point of a batch, on
+     *        several threads.
+     *
+     * @param xs x coordinates of the points.
+     * @param ys y coordinates of the points.
+     * @param num_points Number of points.
+     * @param polygon_ids num_points indices, -1 for the points which are in
+     *        no polygon.
+     * @param num_threads Number of threads, 0 for all the hardware threads.
+     */
+    void find_polygon(const double *xs, const double *ys, size_t num_points,
+                      int32_t *polygon_ids, int num_threads = 0) const;
+
+    size_t size() const { return polygons_.size(); }
+
+   private:
+    struct Box {
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+
+        bool contains(const Eigen::Vector2d &point) const {
+            return min_x <= point.x() && point.x() <= max_x &&
+                   min_y <= point.y() && point.y() <= max_y;
+        }
+    };
+
+    struct Children {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    /**
+     * @brief Sort-Tile-Recursive order of boxes, in which every
+     *        node_capacity consecutive boxes make a node.
+     *
+     */
+    std::vector<uint32_t> packing_order(const std::vector<Box> &boxes) const;
+    /**
+     * @brief Call f(polygon) for every polygon whose box holds the point.
+     *
+     */
+    template <typename F>
+    void for_each_candidate(const Eigen::Vector2d &query_point, F f) const;
+    /**
+     * @brief Check if a polygon contains a point, inside or on it.
+     *
+     */
+    bool contains(int32_t polygon, const Eigen::Vector2d &query_point) const;
+
+    size_t node_capacity_ = 16;
+    std::vector<std::vector<Eigen::Vector2d>> polygons_;
+    // Fan of every convex polygon, convex_of_polygon_[i] being the index of
+    // the fan of polygon i or -1 when it is not convex.
+    std::vector<ConvexPolygon> convex_polygons_;
+    std::vector<int32_t> convex_of_polygon_;
+    // Boxes of every node, the polygons first in packing order, then every
+    // level of nodes up to the root, which is the last one.
+    std::vector<Box> boxes_;
+    // Children of node i >= size() are the nodes [children_[i - size()].begin,
+    // children_[i - size()].end) of the level below.
+    std::vector<Children> children_;
+    // Polygon of every box of the first level.
+    std::vector<int32_t> polygon_of_box_;
+};
+
+#endif  // POINT_IN_POLYGON_POLYGON_RTREE_H_
@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Fill a grid with the cells inside, on or outside a polygon, a row of
+ *        cells at a time instead of a query per cell.
+ *
+ */
+#ifndef POINT_IN_POLYGON_RASTERIZE_POLYGON_H_
+#define POINT_IN_POLYGON_RASTERIZE_POLYGON_H_
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Rule deciding which points are inside a polygon whose sides cross
+ *        or go around several times.
+ *
+ */
+enum class FillRule : uint8_t {
+    // Inside when the winding number is not 0, as in is_point_inside_polygon.
+    kNonZero,
+    // Inside when a ray from the point crosses the sides an odd number of
+    // times.
+    kEvenOdd,
+};
+
+/**
+ * @brief Grid of square cells, row 0 at the bottom and column 0 on the left.
+ *
+ */
+struct RasterGrid {
+    Eigen::Vector2d origin{0.0, 0.0};  // Bottom left corner of the grid.
+    double cell_size = 1.0;
+    int rows = 0;
+    int cols = 0;
+
+    /**
+     * @brief Center of a cell, the point the cell is classified by.
+     *
+     */
+    Eigen::Vector2d cell_center(const int row, const int col) const {
+        return {origin.x() + (col + 0.5) * cell_size,
+                origin.y() + (row + 0.5) * cell_size};
+    }
+};
+
+/**
+ * @brief Classify the center of every cell of a grid, with a scanline over
+ *        the rows in O(cells + edges) instead of a query per cell.
+ *
+ * With the non zero rule every cell gets the result is_point_inside_polygon
+ * gives for its center.
+ *
+ * @param vertices Vertices making up the polygon.
+ * @param grid The grid.
+ * @param mask rows * cols results in row major order, 1 inside, 0 on and -1
+ *        outside the polygon.
+ * @param fill_rule Rule deciding which points are inside.
+ * @param mark_boundary_cells Also mark as on the polygon every cell touched
+ *        by a side, whether or not its center is on the side.
+ */
+void rasterize_polygon(const std::vector<Eigen::Vector2d> &vertices,
+                       const RasterGrid &grid, std::vector<int8_t> *mask,
+                       FillRule fill_rule = FillRule::kNonZero,
+                       bool mark_boundary_cells = false);
+
+#endif  // POINT_IN_POLYGON_RASTERIZE_POLYGON_H_
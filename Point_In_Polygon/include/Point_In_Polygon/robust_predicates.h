@@ -0,0 +1,65 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Orientation of a point relative to a line with an exact sign, using
+ *        floating point arithmetic when its result is certain and exact
+ *        arithmetic only when it is not, after J. R. Shewchuk, "Adaptive
+ *        Precision Floating-Point Arithmetic and Fast Robust Geometric
+ *        Predicates", 1997.
+ *
+ */
+#ifndef POINT_IN_POLYGON_ROBUST_PREDICATES_H_
+#define POINT_IN_POLYGON_ROBUST_PREDICATES_H_
+
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Relative error bound of the floating point orientation, the
+ *        absolute error is below it times |left| + |right| (ccwerrboundA in
+ *        Shewchuk's predicates).
+ *
+ */
+constexpr double kOrientationErrorBound =
+    (3.0 + 16.0 * (std::numeric_limits<double>::epsilon() / 2)) *
+    (std::numeric_limits<double>::epsilon() / 2);
+
+/**
+ * @brief Exact orientation of (qx, qy) relative to the line from (x1, y1) to
+ *        (x2, y2), evaluated with expansion arithmetic.
+ *
+ * @return A value with the sign of the exact orientation, 0 only when the
+ *         three points are exactly collinear.
+ */
+double orientation_exact(double x1, double y1, double x2, double y2, double qx,
+                         double qy);
+
+/**
+ * @brief Orientation of (qx, qy) relative to the line from (x1, y1) to
+ *        (x2, y2), the same cross product as substitute_point_in_line.
+ *
+ * @return: > 0: Query point lies on left of the line.
+ *          = 0: Query point lies on the line, exactly.
+ *          < 0: Query point lies on right of the line.
+ *          The sign is always exact, assuming no overflow or underflow.
+ */
+inline double orientation(const double x1, const double y1, const double x2,
+                          const double y2, const double qx, const double qy) {
+    const double left = (qy - y1) * (x2 - x1);
+    const double right = (qx - x1) * (y2 - y1);
+    const double det = left - right;
+    const double error_bound =
+        kOrientationErrorBound * (std::abs(left) + std::abs(right));
+    // Both products are exactly 0 only when a factor is, the point is then
+    // exactly on the line.
+    if (det > error_bound || -det > error_bound || error_bound == 0) {
+        return det;
+    }
+    return orientation_exact(x1, y1, x2, y2, qx, qy);
+}
+
+#endif  // POINT_IN_POLYGON_ROBUST_PREDICATES_H_
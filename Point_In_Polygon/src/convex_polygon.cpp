@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Check if a Point is Inside, On or Outside a convex polygon in
+ *        O(log n), and detect the polygons which are convex.
+ *
+ */
+
+#include "Point_In_Polygon/convex_polygon.h"
+
+#include <algorithm>
+
+#include "Point_In_Polygon/point_in_polygon.h"
+
+namespace {
+/**
+ * @brief Number of times the sign of the non zero values changes going
+ *        around the polygon.
+ *
+ */
+int count_sign_changes(const std::vector<int> &signs) {
+    int num_changes = 0;
+    for (size_t i = 0; i < signs.size(); ++i) {
+        num_changes += signs[i] != signs[(i + 1) % signs.size()];
+    }
+    return num_changes;
+}
+
+/**
+ * @brief The vertices without the repeated ones, a vertex equal to the next
+ *        one going around the polygon is dropped.
+ *
+ */
+std::vector<Eigen::Vector2d> distinct_vertices(
+    const std::vector<Eigen::Vector2d> &vertices) {
+    std::vector<Eigen::Vector2d> distinct;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (vertices[i] != vertices[(i + 1) % vertices.size()]) {
+            distinct.push_back(vertices[i]);
+        }
+    }
+    return distinct;
+}
+}  // namespace
+
+bool is_convex_polygon(const std::vector<Eigen::Vector2d> &polygon) {
+    // The turn at a repeated vertex is between the sides around the repeats.
+    const std::vector<Eigen::Vector2d> vertices = distinct_vertices(polygon);
+    const size_t num_sides_of_polygon = vertices.size();
+    if (num_sides_of_polygon < 3) {
+        return false;
+    }
+    int turn = 0;
+    std::vector<int> x_signs;
+    std::vector<int> y_signs;
+    for (size_t i = 0; i < num_sides_of_polygon; ++i) {
+        const Eigen::Vector2d &pt1 = vertices[i];
+        const Eigen::Vector2d &pt2 = vertices[(i + 1) % num_sides_of_polygon];
+        const Eigen::Vector2d &pt3 = vertices[(i + 2) % num_sides_of_polygon];
+        const double point_in_line = substitute_point_in_line(pt1, pt2, pt3);
+        if (point_in_line != 0) {
+            const int side_turn = point_in_line > 0 ? 1 : -1;
+            if (turn != 0 && side_turn != turn) {
+                return false;
+            }
+            turn = side_turn;
+        }
+        if (pt2.x() != pt1.x()) {
+            x_signs.push_back(pt2.x() > pt1.x() ? 1 : -1);
+        }
+        if (pt2.y() != pt1.y()) {
+            y_signs.push_back(pt2.y() > pt1.y() ? 1 : -1);
+        }
+    }
+    // Turning the same way is not enough, a star turns the same way at every
+    // vertex and goes around several times. Going around once, the sides go
+    // right then left, and up then down, once each.
+    return turn != 0 && count_sign_changes(x_signs) <= 2 &&
+           count_sign_changes(y_signs) <= 2;
+}
+
+ConvexPolygon::ConvexPolygon(const std::vector<Eigen::Vector2d> &vertices) {
+    // Repeated vertices first, then the collinear ones, which leaves the
+    // corners of the polygon.
+    const std::vector<Eigen::Vector2d> distinct = distinct_vertices(vertices);
+    const size_t num_distinct = distinct.size();
+    for (size_t i = 0; i < num_distinct; ++i) {
+        const Eigen::Vector2d &previous =
+            distinct[(i + num_distinct - 1) % num_distinct];
+        const Eigen::Vector2d &next = distinct[(i + 1) % num_distinct];
+        if (substitute_point_in_line(previous, distinct[i], next) != 0) {
+            vertices_.push_back(distinct[i]);
+        }
+    }
+    if (vertices_.size() >= 3 &&
+        substitute_point_in_line(vertices_[0], vertices_[1], vertices_[2]) <
+            0) {
+        std::reverse(vertices_.begin(), vertices_.end());
+    }
+}
+
+int ConvexPolygon::is_point_inside(const Eigen::Vector2d &query_point) const {
+    const size_t num_vertices = vertices_.size();
+    if (num_vertices < 3) {
+        return -1;
+    }
+    const Eigen::Vector2d &pivot = vertices_[0];
+    // The point must lie in the corner at the pivot, between its two sides.
+    const double first_side =
+        substitute_point_in_line(pivot, vertices_[1], query_point);
+    const double last_side =
+        substitute_point_in_line(pivot, vertices_[num_vertices - 1],
+                                 query_point);
+    if (first_side < 0 || last_side > 0) {
+        return -1;
+    }
+    if (first_side == 0) {
+        return is_point_within_segment_bounds(pivot, vertices_[1], query_point)
+                   ? 0
+                   : -1;
+    }
+    if (last_side == 0) {
+        return is_point_within_segment_bounds(
+                   pivot, vertices_[num_vertices - 1], query_point)
+                   ? 0
+                   : -1;
+    }
+    // The point is left of the diagonal to vertex low and right of the one
+    // to vertex high, narrowed down to the wedge of a single side.
+    size_t low = 1;
+    size_t high = num_vertices - 1;
+    while (high - low > 1) {
+        const size_t middle = low + (high - low) / 2;
+        if (substitute_point_in_line(pivot, vertices_[middle], query_point) >=
+            0) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    const double point_in_line =
+        substitute_point_in_line(vertices_[low], vertices_[high], query_point);
+    if (point_in_line == 0) {
+        return 0;
+    }
+    return point_in_line > 0 ? 1 : -1;
+}
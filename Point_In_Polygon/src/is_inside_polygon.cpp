@@ -0,0 +1,259 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Test some query points against differently shaped polygons.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Point_In_Polygon/convex_polygon.h"
+#include "Point_In_Polygon/point_in_polygon.h"
+#include "Point_In_Polygon/polygon_index.h"
+#include "Point_In_Polygon/polygon_rtree.h"
+#include "Point_In_Polygon/rasterize_polygon.h"
+
+int main() {
+    // Map to make printing easier.
+    std::unordered_map<int, std::string> get_value{
+        {-1, "outisde"}, {0, "on"}, {1, "inside"}};
+    // Non Convex Polygon
+    {
+        std::cout << "For Non Convex Polygon...\n" << std::endl;
+        // Vetices need to be in anticlockwise direction to fix the notion of
+        // left and right of edges made in the comments.
+        std::vector<Eigen::Vector2d> vertices{{0, 0}, {3, 1}, {6, 0}, {3, 5}};
+        std::vector<Eigen::Vector2d> query_points{
+            {3, 2}, {3, 6}, {3, 1}, {0, 0}, {15, 20}};
+        for (const auto &point : query_points) {
+            std::cout << "Point: " << point.transpose() << " lies "
+                      << get_value[is_point_inside_polygon(point, vertices)]
+                      << " the polygon." << std::endl;
+        }
+    }
+
+    std::cout << "\n";
+
+    // Convex Polygons, checked with the functions for convex polygons only.
+    std::cout << "For Convex Polygon..." << std::endl;
+    // Triangle
+    {
+        std::cout << "For Triangle\n" << std::endl;
+        std::vector<Eigen::Vector2d> vertices{{0, 0}, {6, 0}, {3, 5}};
+        std::vector<Eigen::Vector2d> query_points{
+            {3, 2}, {3, 6}, {3, 5}, {0, 0}, {15, 20}};
+        const ConvexPolygon polygon(vertices);
+        for (const auto &point : query_points) {
+            std::cout << "Point: " << point.transpose() << " lies "
+                      << get_value[polygon.is_point_inside(point)]
+                      << " the polygon." << std::endl;
+        }
+    }
+
+    std::cout << "\n";
+
+    // Quadrilateral
+    {
+        std::cout << "For convex Quadrilateral\n" << std::endl;
+        std::vector<Eigen::Vector2d> vertices{{0, 0}, {6, 0}, {6, 6}, {-1, 10}};
+        std::vector<Eigen::Vector2d> query_points{
+            {3, 2}, {3, 6}, {3, 5}, {0, 0}, {15, 20}};
+        for (const auto &point : query_points) {
+            std::cout
+                << "Point: " << point.transpose() << " lies "
+                << get_value[is_point_inside_convex_polygon(point, vertices)]
+                << " the polygon." << std::endl;
+        }
+    }
+
+    std::cout << "\n";
+
+    // Batch of points
+    {
+        std::cout << "For a batch of random points\n" << std::endl;
+        std::vector<Eigen::Vector2d> vertices{{0, 0}, {3, 1}, {6, 0}, {3, 5}};
+        const size_t num_points = 1000000;
+        std::vector<double> xs(num_points);
+        std::vector<double> ys(num_points);
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> coordinate(-1.0, 7.0);
+        for (size_t i = 0; i < num_points; ++i) {
+            // Half of the points are on the grid of the vertices, so that
+            // some of them lie on the polygon.
+            xs[i] = coordinate(generator);
+            ys[i] = coordinate(generator);
+            if (i % 2 == 0) {
+                xs[i] = std::round(xs[i]);
+                ys[i] = std::round(ys[i]);
+            }
+        }
+        std::vector<int8_t> results(num_points);
+        const auto start = std::chrono::steady_clock::now();
+        are_points_inside_polygon(xs.data(), ys.data(), num_points, vertices,
+                                  results.data());
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        size_t num_mismatches = 0;
+        for (size_t i = 0; i < num_points; ++i) {
+            num_mismatches +=
+                results[i] !=
+                is_point_inside_polygon({xs[i], ys[i]}, vertices);
+        }
+        std::cout << num_points << " points classified in " << 1e3 * seconds
+                  << " ms, " << num_mismatches
+                  << " differ from one point at a time." << std::endl;
+    }
+
+    std::cout << "\n";
+
+    // Polygon with many vertices
+    {
+        std::cout << "For a polygon with 100000 vertices\n" << std::endl;
+        std::vector<Eigen::Vector2d> vertices;
+        const int num_vertices = 100000;
+        for (int i = 0; i < num_vertices; ++i) {
+            const double angle = 2 * M_PI * i / num_vertices;
+            const double radius = 1 + 0.2 * std::sin(37 * angle);
+            vertices.emplace_back(radius * std::cos(angle),
+                                  radius * std::sin(angle));
+        }
+        auto start = std::chrono::steady_clock::now();
+        const PolygonIndex index(vertices);
+        const double build_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> coordinate(-1.3, 1.3);
+        const size_t num_points = 1000;
+        std::vector<Eigen::Vector2d> query_points;
+        for (size_t i = 0; i < num_points; ++i) {
+            query_points.emplace_back(coordinate(generator),
+                                      coordinate(generator));
+        }
+        std::vector<int> results(num_points);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_points; ++i) {
+            results[i] = index.is_point_inside(query_points[i]);
+        }
+        const double index_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        size_t num_mismatches = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_points; ++i) {
+            num_mismatches += results[i] != is_point_inside_polygon(
+                                                  query_points[i], vertices);
+        }
+        const double linear_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        std::cout << "Index built in " << 1e3 * build_seconds << " ms, "
+                  << 1e6 * index_seconds / num_points
+                  << " us per point against "
+                  << 1e6 * linear_seconds / num_points
+                  << " us testing every edge, " << num_mismatches
+                  << " results differ." << std::endl;
+    }
+
+    std::cout << "\n";
+
+    // Many polygons
+    {
+        std::cout << "For 50000 polygons\n" << std::endl;
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+        std::uniform_real_distribution<double> size(0.5, 4.0);
+        std::vector<std::vector<Eigen::Vector2d>> polygons(50000);
+        for (auto &polygon : polygons) {
+            const Eigen::Vector2d center(coordinate(generator),
+                                         coordinate(generator));
+            const double radius = size(generator);
+            for (int i = 0; i < 8; ++i) {
+                const double angle = 2 * M_PI * i / 8;
+                polygon.push_back(center + radius * Eigen::Vector2d(
+                                                        std::cos(angle),
+                                                        std::sin(angle)));
+            }
+        }
+        const PolygonRTree tree(polygons);
+        const size_t num_points = 100000;
+        std::vector<double> xs(num_points);
+        std::vector<double> ys(num_points);
+        for (size_t i = 0; i < num_points; ++i) {
+            xs[i] = coordinate(generator);
+            ys[i] = coordinate(generator);
+        }
+        std::vector<int32_t> polygon_ids(num_points);
+        const auto start = std::chrono::steady_clock::now();
+        tree.find_polygon(xs.data(), ys.data(), num_points,
+                          polygon_ids.data());
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        const size_t num_found =
+            num_points -
+            std::count(polygon_ids.begin(), polygon_ids.end(), -1);
+        std::cout << num_found << " of " << num_points
+                  << " points found in a polygon in " << 1e3 * seconds
+                  << " ms." << std::endl;
+    }
+
+    std::cout << "\n";
+
+    // Occupancy mask
+    {
+        std::cout << "For a 500 x 500 mask of a 2000 vertex star\n"
+                  << std::endl;
+        std::vector<Eigen::Vector2d> vertices;
+        for (int i = 0; i < 2000; ++i) {
+            const double angle = 2 * M_PI * i / 2000;
+            const double radius = i % 2 ? 40.0 : 100.0;
+            vertices.emplace_back(radius * std::cos(angle),
+                                  radius * std::sin(angle));
+        }
+        RasterGrid grid;
+        grid.origin = {-100.0, -100.0};
+        grid.cell_size = 0.4;
+        grid.rows = grid.cols = 500;
+        std::vector<int8_t> mask;
+        auto start = std::chrono::steady_clock::now();
+        rasterize_polygon(vertices, grid, &mask);
+        const double raster_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        size_t num_mismatches = 0;
+        start = std::chrono::steady_clock::now();
+        for (int row = 0; row < grid.rows; ++row) {
+            for (int col = 0; col < grid.cols; ++col) {
+                num_mismatches +=
+                    mask[static_cast<size_t>(row) * grid.cols + col] !=
+                    is_point_inside_polygon(grid.cell_center(row, col),
+                                            vertices);
+            }
+        }
+        const double per_cell_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        std::cout << "Mask filled in " << 1e3 * raster_seconds
+                  << " ms against " << 1e3 * per_cell_seconds
+                  << " ms testing every cell, " << num_mismatches
+                  << " cells differ." << std::endl;
+    }
+}
@@ -17,11 +17,11 @@
  *
  */
 
-#include <Eigen/Dense>
+#include "Point_In_Polygon/point_in_polygon.h"
+#include "Point_In_Polygon/robust_predicates.h"
+
+#include <algorithm>
 #include <cmath>
-#include <iostream>
-#include <unordered_map>
-#include <vector>
 
 /**
  * @brief The result can be used to test if the query point lies on the left or
@@ -38,10 +38,29 @@
 double substitute_point_in_line(const Eigen::Vector2d &pt1,
                                 const Eigen::Vector2d &pt2,
                                 const Eigen::Vector2d &query_point) {
-    return ((query_point.y() - pt1.y()) * (pt2.x() - pt1.x())) -
-           ((query_point.x() - pt1.x()) * (pt2.y() - pt1.y()));
+    return orientation(pt1.x(), pt1.y(), pt2.x(), pt2.y(), query_point.x(),
+                       query_point.y());
 };
 
+/**
+ * @brief Check if a point lies within the bounding box of a segment. For a
+ *        point on the line through the segment, it tells if the point lies on
+ *        the segment itself.
+ *
+ * @param pt1: First end of the segment.
+ * @param pt2: Second end of the segment.
+ * @param query_point: Query point
+ * @return: true if the point lies within the box.
+ */
+bool is_point_within_segment_bounds(const Eigen::Vector2d &pt1,
+                                    const Eigen::Vector2d &pt2,
+                                    const Eigen::Vector2d &query_point) {
+    return std::min(pt1.x(), pt2.x()) <= query_point.x() &&
+           query_point.x() <= std::max(pt1.x(), pt2.x()) &&
+           std::min(pt1.y(), pt2.y()) <= query_point.y() &&
+           query_point.y() <= std::max(pt1.y(), pt2.y());
+}
+
 /**
  * @brief Check if a point lies inside, on or outside a convex polygon.
  *
@@ -50,28 +69,47 @@ double substitute_point_in_line(const Eigen::Vector2d &pt1,
  * lies on the same side of all the line segments making up the path.
  *
  * @param query_point Point to check.
- * @param vertices Vertices making up the polygon.
+ * @param vertices Vertices making up the polygon, in either direction.
  * @return  = 1: query_point lies inside the polygon.
  *          = 0: query_point lies on the polygon.
  *          =-1: query_point lies outside the polygon.
  */
-int is_point_inside_convex_polygon(const Eigen::Vector2d &query_point,
-                                   std::vector<Eigen::Vector2d> &vertices) {
+int is_point_inside_convex_polygon(
+    const Eigen::Vector2d &query_point,
+    const std::vector<Eigen::Vector2d> &vertices) {
     const int num_sides_of_polygon = vertices.size();
-    int count_same_side_results = 0;
+    int count_sides = 0;
+    int count_left_results = 0;
+    int count_right_results = 0;
     // Iterate over each side.
     for (size_t i = 0; i < num_sides_of_polygon; ++i) {
+        // A repeated vertex makes a side without a line to be on either side
+        // of.
+        if (vertices[i] == vertices[(i + 1) % num_sides_of_polygon]) {
+            continue;
+        }
+        ++count_sides;
         const auto point_in_line = substitute_point_in_line(
             vertices[i], vertices[(i + 1) % num_sides_of_polygon], query_point);
 
-        // Check if the point lies on the polygon.
-        if (point_in_line == 0) {
-            return point_in_line;
+        // Check if the point lies on the polygon, on the side itself and not
+        // only on the line through it.
+        if (point_in_line == 0 &&
+            is_point_within_segment_bounds(
+                vertices[i], vertices[(i + 1) % num_sides_of_polygon],
+                query_point)) {
+            return 0;
         }
 
-        count_same_side_results += point_in_line > 0;
+        count_left_results += point_in_line > 0;
+        count_right_results += point_in_line < 0;
     }
-    return (std::abs(count_same_side_results) == num_sides_of_polygon) ? 1 : -1;
+    // Anticlockwise vertices have the inside on the left of every side,
+    // clockwise ones on the right.
+    return (count_sides > 0 && (count_left_results == count_sides ||
+                                count_right_results == count_sides))
+               ? 1
+               : -1;
 }
 
 /**
@@ -89,7 +127,7 @@ int is_point_inside_convex_polygon(const Eigen::Vector2d &query_point,
  *          =-1: query_point lies outside the polygon.
  */
 int is_point_inside_polygon(const Eigen::Vector2d &query_point,
-                            std::vector<Eigen::Vector2d> &vertices) {
+                            const std::vector<Eigen::Vector2d> &vertices) {
     int wn = 0;  // the  winding number counter
     const int num_sides_of_polygon = vertices.size();
 
@@ -97,8 +135,12 @@ int is_point_inside_polygon(const Eigen::Vector2d &query_point,
         const auto point_in_line = substitute_point_in_line(
             vertices[i], vertices[(i + 1) % num_sides_of_polygon], query_point);
 
-        // Check if the point lies on the polygon.
-        if (point_in_line == 0) {
+        // Check if the point lies on the polygon, on the edge itself and not
+        // only on the line through it.
+        if (point_in_line == 0 &&
+            is_point_within_segment_bounds(
+                vertices[i], vertices[(i + 1) % num_sides_of_polygon],
+                query_point)) {
             return 0;
         }
         if (vertices[i].y() <= query_point.y()) {
@@ -110,8 +152,9 @@ int is_point_inside_polygon(const Eigen::Vector2d &query_point,
                 }
             }
         } else {
-            // Downward crossing.
-            if (vertices[(i + 1) % num_sides_of_polygon].y() <
+            // Downward crossing. An edge ending at the height of the point
+            // counts, as an upward edge starting there does.
+            if (vertices[(i + 1) % num_sides_of_polygon].y() <=
                 query_point.y()) {
                 if (point_in_line < 0) {
                     --wn;  // query point is right of edge
@@ -121,55 +164,3 @@ int is_point_inside_polygon(const Eigen::Vector2d &query_point,
     }
     return (wn != 0) ? 1 : -1;  // Point is inside polygon only if wn != 0
 }
-
-int main() {
-    // Map to make printing easier.
-    std::unordered_map<int, std::string> get_value{
-        {-1, "outisde"}, {0, "on"}, {1, "inside"}};
-    // Non Convex Polygon
-    {
-        std::cout << "For Non Convex Polygon...\n" << std::endl;
-        // Vetices need to be in anticlockwise direction to fix the notion of
-        // left and right of edges made in the comments.
-        std::vector<Eigen::Vector2d> vertices{{0, 0}, {3, 1}, {6, 0}, {3, 5}};
-        std::vector<Eigen::Vector2d> query_points{
-            {3, 2}, {3, 6}, {3, 1}, {0, 0}, {15, 20}};
-        for (const auto &point : query_points) {
-            std::cout << "Point: " << point.transpose() << " lies "
-                      << get_value[is_point_inside_polygon(point, vertices)]
-                      << " the polygon." << std::endl;
-        }
-    }
-
-    std::cout << "\n";
-
-    // Convex Polygons
-    std::cout << "For Convex Polygon..." << std::endl;
-    // Triangle
-    {
-        std::cout << "For Triangle\n" << std::endl;
-        std::vector<Eigen::Vector2d> vertices{{0, 0}, {6, 0}, {3, 5}};
-        std::vector<Eigen::Vector2d> query_points{
-            {3, 2}, {3, 6}, {3, 5}, {0, 0}, {15, 20}};
-        for (const auto &point : query_points) {
-            std::cout << "Point: " << point.transpose() << " lies "
-                      << get_value[is_point_inside_polygon(point, vertices)]
-                      << " the polygon." << std::endl;
-        }
-    }
-
-    std::cout << "\n";
-
-    // Quadrilateral
-    {
-        std::cout << "For convex Quadrilateral\n" << std::endl;
-        std::vector<Eigen::Vector2d> vertices{{0, 0}, {6, 0}, {6, 6}, {-1, 10}};
-        std::vector<Eigen::Vector2d> query_points{
-            {3, 2}, {3, 6}, {3, 5}, {0, 0}, {15, 20}};
-        for (const auto &point : query_points) {
-            std::cout << "Point: " << point.transpose() << " lies "
-                      << get_value[is_point_inside_polygon(point, vertices)]
-                      << " the polygon." << std::endl;
-        }
-    }
-}
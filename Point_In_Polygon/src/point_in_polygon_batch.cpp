@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Check if a batch of points lie Inside, On or Outside a given Polygon
+ *        with the winding number algorithm, several points per instruction
+ *        and on several threads, or with the binary search of ConvexPolygon
+ *        for large convex polygons.
+ *
+ */
+
+#include <algorithm>
+
+#include "Point_In_Polygon/parallel.h"
+#include "Point_In_Polygon/point_in_polygon.h"
+#include "Point_In_Polygon/robust_predicates.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+// Smallest number of points given to a thread.
+constexpr size_t kMinPointsPerThread = 4096;
+
+// Fewest vertices of a convex polygon for which the O(log n) search of
+// ConvexPolygon is faster than testing every edge, 4 points at a time with
+// AVX2 and one at a time without.
+#ifdef __AVX2__
+constexpr size_t kMinConvexVertices = 128;
+#else
+constexpr size_t kMinConvexVertices = 12;
+#endif
+
+/**
+ * @brief Winding number test of points [begin, end) with one point at a time.
+ *        Same steps as is_point_inside_polygon on the precomputed edges.
+ *
+ */
+void classify_points(const double *xs, const double *ys, const size_t begin,
+                     const size_t end, const PolygonEdges &edges,
+                     int8_t *results) {
+    const size_t num_edges = edges.size();
+    for (size_t p = begin; p < end; ++p) {
+        const double x = xs[p];
+        const double y = ys[p];
+        int wn = 0;
+        bool on_polygon = false;
+        for (size_t i = 0; i < num_edges; ++i) {
+            const double point_in_line =
+                orientation(edges.x1[i], edges.y1[i], edges.x2[i],
+                            edges.y2[i], x, y);
+            on_polygon |=
+                point_in_line == 0 &&
+                std::min(edges.x1[i], edges.x2[i]) <= x &&
+                x <= std::max(edges.x1[i], edges.x2[i]) &&
+                std::min(edges.y1[i], edges.y2[i]) <= y &&
+                y <= std::max(edges.y1[i], edges.y2[i]);
+            if (edges.y1[i] <= y) {
+                wn += edges.y2[i] > y && point_in_line > 0;
+            } else {
+                wn -= edges.y2[i] <= y && point_in_line < 0;
+            }
+        }
+        results[p] = on_polygon ? 0 : (wn != 0 ? 1 : -1);
+    }
+}
+
+#ifdef __AVX2__
+/**
+ * @brief Same test with 4 points per instruction, for as many groups of 4
+ *        points as there are in [begin, end).
+ *
+ * @return Index of the first point left to classify.
+ */
+size_t classify_points_avx2(const double *xs, const double *ys,
+                            const size_t begin, const size_t end,
+                            const PolygonEdges &edges, int8_t *results) {
+    const size_t num_edges = edges.size();
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d error_bound = _mm256_set1_pd(kOrientationErrorBound);
+    // Clears the sign bit.
+    const __m256d abs_mask =
+        _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+    size_t p = begin;
+    for (; p + 4 <= end; p += 4) {
+        const __m256d x = _mm256_loadu_pd(xs + p);
+        const __m256d y = _mm256_loadu_pd(ys + p);
+        __m256d wn = zero;
+        __m256d uncertain = zero;
+        for (size_t i = 0; i < num_edges; ++i) {
+            const __m256d y1 = _mm256_broadcast_sd(&edges.y1[i]);
+            const __m256d y2 = _mm256_broadcast_sd(&edges.y2[i]);
+            // No fused multiply add, so that the results are exactly those of
+            // one point at a time.
+            const __m256d left = _mm256_mul_pd(
+                _mm256_sub_pd(y, y1), _mm256_broadcast_sd(&edges.dx[i]));
+            const __m256d right = _mm256_mul_pd(
+                _mm256_sub_pd(x, _mm256_broadcast_sd(&edges.x1[i])),
+                _mm256_broadcast_sd(&edges.dy[i]));
+            const __m256d point_in_line = _mm256_sub_pd(left, right);
+            // The sign of point_in_line may be wrong when it is within the
+            // error bound of the orientation, 0 included.
+            uncertain = _mm256_or_pd(
+                uncertain,
+                _mm256_cmp_pd(
+                    _mm256_and_pd(point_in_line, abs_mask),
+                    _mm256_mul_pd(error_bound,
+                                  _mm256_add_pd(_mm256_and_pd(left, abs_mask),
+                                                _mm256_and_pd(right, abs_mask))),
+                    _CMP_LE_OQ));
+            const __m256d start_below = _mm256_cmp_pd(y1, y, _CMP_LE_OQ);
+            // Upward crossing with the point on the left of the edge.
+            const __m256d up = _mm256_and_pd(
+                _mm256_and_pd(start_below, _mm256_cmp_pd(y2, y, _CMP_GT_OQ)),
+                _mm256_cmp_pd(point_in_line, zero, _CMP_GT_OQ));
+            // Downward crossing with the point on the right of the edge.
+            const __m256d down = _mm256_andnot_pd(
+                start_below,
+                _mm256_and_pd(_mm256_cmp_pd(y2, y, _CMP_LE_OQ),
+                              _mm256_cmp_pd(point_in_line, zero, _CMP_LT_OQ)));
+            wn = _mm256_add_pd(wn, _mm256_and_pd(up, one));
+            wn = _mm256_sub_pd(wn, _mm256_and_pd(down, one));
+        }
+        const int inside = ~_mm256_movemask_pd(
+                               _mm256_cmp_pd(wn, zero, _CMP_EQ_OQ)) &
+                           0xF;
+        for (int lane = 0; lane < 4; ++lane) {
+            results[p + lane] = (inside >> lane) & 1 ? 1 : -1;
+        }
+        // Points on or very close to the line through an edge may be on the
+        // edge or on the wrong side of it. Such points are rare, they are
+        // checked again one at a time with the exact orientation.
+        const int recheck = _mm256_movemask_pd(uncertain);
+        for (int lane = 0; lane < 4; ++lane) {
+            if ((recheck >> lane) & 1) {
+                classify_points(xs, ys, p + lane, p + lane + 1, edges,
+                                results);
+            }
+        }
+    }
+    return p;
+}
+#endif
+}  // namespace
+
+PolygonEdges::PolygonEdges(const std::vector<Eigen::Vector2d> &vertices) {
+    const size_t num_sides_of_polygon = vertices.size();
+    x1.resize(num_sides_of_polygon);
+    y1.resize(num_sides_of_polygon);
+    x2.resize(num_sides_of_polygon);
+    y2.resize(num_sides_of_polygon);
+    dx.resize(num_sides_of_polygon);
+    dy.resize(num_sides_of_polygon);
+    for (size_t i = 0; i < num_sides_of_polygon; ++i) {
+        // The modulo is only needed by the last edge, it is done once here
+        // instead of for every point.
+        const Eigen::Vector2d &next =
+            vertices[i + 1 < num_sides_of_polygon ? i + 1 : 0];
+        x1[i] = vertices[i].x();
+        y1[i] = vertices[i].y();
+        x2[i] = next.x();
+        y2[i] = next.y();
+        dx[i] = next.x() - vertices[i].x();
+        dy[i] = next.y() - vertices[i].y();
+    }
+    if (num_sides_of_polygon >= kMinConvexVertices &&
+        is_convex_polygon(vertices)) {
+        convex.emplace(vertices);
+    }
+}
+
+void are_points_inside_polygon(const double *xs, const double *ys,
+                               const size_t num_points,
+                               const std::vector<Eigen::Vector2d> &vertices,
+                               int8_t *results, const int num_threads) {
+    are_points_inside_polygon(xs, ys, num_points, PolygonEdges(vertices),
+                              results, num_threads);
+}
+
+void are_points_inside_polygon(const double *xs, const double *ys,
+                               const size_t num_points,
+                               const PolygonEdges &edges, int8_t *results,
+                               const int num_threads) {
+    if (edges.convex) {
+        const ConvexPolygon &convex = *edges.convex;
+        parallel_for(num_points, num_threads, kMinPointsPerThread,
+                     [&](const size_t begin, const size_t end) {
+                         for (size_t p = begin; p < end; ++p) {
+                             results[p] = static_cast<int8_t>(
+                                 convex.is_point_inside({xs[p], ys[p]}));
+                         }
+                     });
+        return;
+    }
+    auto classify = [&](const size_t begin, const size_t end) {
+        size_t first = begin;
+#ifdef __AVX2__
+        first = classify_points_avx2(xs, ys, begin, end, edges, results);
+#endif
+        classify_points(xs, ys, first, end, edges, results);
+    };
+    parallel_for(num_points, num_threads, kMinPointsPerThread, classify);
+}
@@ -0,0 +1,280 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Index over the edges of a polygon, built once, so that a query only
+ *        tests the few edges around the query point instead of all of them.
+ *
+ */
+
+#include "Point_In_Polygon/polygon_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Point_In_Polygon/point_in_polygon.h"
+#include "Point_In_Polygon/polygon_grid.h"
+
+namespace {
+// Most vertices of a convex polygon for which the binary search of
+// ConvexPolygon is faster than the grid.
+constexpr size_t kMaxConvexVertices = 12;
+
+/**
+ * @brief Contribution of an edge to the winding number of a point, with a ray
+ *        going right from the point as in is_point_inside_polygon.
+ *
+ * @param point_in_line substitute_point_in_line of the point in the edge.
+ */
+int horizontal_crossing(const Eigen::Vector2d &pt1, const Eigen::Vector2d &pt2,
+                        const Eigen::Vector2d &query_point,
+                        const double point_in_line) {
+    if (pt1.y() <= query_point.y()) {
+        return pt2.y() > query_point.y() && point_in_line > 0;
+    }
+    return -(pt2.y() <= query_point.y() && point_in_line < 0);
+}
+
+/**
+ * @brief Same with a ray going up from the point, the test above rotated by a
+ *        quarter turn clockwise. Both give the same winding number for a
+ *        point which is not on the polygon.
+ *
+ */
+int vertical_crossing(const Eigen::Vector2d &pt1, const Eigen::Vector2d &pt2,
+                      const Eigen::Vector2d &query_point,
+                      const double point_in_line) {
+    if (pt1.x() >= query_point.x()) {
+        return pt2.x() < query_point.x() && point_in_line > 0;
+    }
+    return -(pt2.x() >= query_point.x() && point_in_line < 0);
+}
+
+/**
+ * @brief Check if a point lies on the segment from pt1 to pt2.
+ *
+ */
+bool is_point_on_segment(const Eigen::Vector2d &pt1,
+                         const Eigen::Vector2d &pt2,
+                         const Eigen::Vector2d &query_point,
+                         const double point_in_line) {
+    return point_in_line == 0 &&
+           is_point_within_segment_bounds(pt1, pt2, query_point);
+}
+}  // namespace
+
+PolygonIndex::PolygonIndex(const std::vector<Eigen::Vector2d> &vertices,
+                           const double cells_per_edge)
+    : vertices_(vertices) {
+    const size_t num_edges = vertices_.size();
+    if (num_edges == 0) {
+        return;
+    }
+    if (num_edges <= kMaxConvexVertices && is_convex_polygon(vertices_)) {
+        convex_.emplace(vertices_);
+        return;
+    }
+    min_ = max_ = vertices_[0];
+    for (const auto &vertex : vertices_) {
+        min_ = min_.cwiseMin(vertex);
+        max_ = max_.cwiseMax(vertex);
+    }
+    // Cells as close to squares as the bounding box allows. A flat polygon
+    // still gets a non zero cell size along its flat side.
+    Eigen::Vector2d extent = max_ - min_;
+    const double largest_extent = std::max(extent.maxCoeff(), 1.0);
+    extent = extent.cwiseMax(1e-6 * largest_extent);
+    const double num_cells =
+        std::max(1.0, cells_per_edge * static_cast<double>(num_edges));
+    const double side = std::sqrt(extent.x() * extent.y() / num_cells);
+    cols_ = static_cast<int>(
+        std::min(num_cells, std::max(1.0, std::ceil(extent.x() / side))));
+    rows_ = static_cast<int>(
+        std::min(num_cells, std::max(1.0, std::ceil(extent.y() / side))));
+    cell_size_ = {extent.x() / cols_, extent.y() / rows_};
+    // Covers the rounding of the edges and of the query points, so that an
+    // edge is listed in every cell in which a query can meet it.
+    margin_ = 1e-9 * (std::max(min_.cwiseAbs().maxCoeff(),
+                               max_.cwiseAbs().maxCoeff()) +
+                      largest_extent);
+
+    // Edges of every cell, counted then filled.
+    const size_t total_cells = static_cast<size_t>(rows_) * cols_;
+    cell_offsets_.assign(total_cells + 1, 0);
+    for (size_t edge = 0; edge < num_edges; ++edge) {
+        for_each_cell_of_edge(edge,
+                              [this](const size_t cell) {
+                                  ++cell_offsets_[cell + 1];
+                              });
+    }
+    for (size_t cell = 0; cell < total_cells; ++cell) {
+        cell_offsets_[cell + 1] += cell_offsets_[cell];
+    }
+    cell_edges_.resize(cell_offsets_[total_cells]);
+    std::vector<uint32_t> fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t edge = 0; edge < num_edges; ++edge) {
+        for_each_cell_of_edge(edge, [&](const size_t cell) {
+            cell_edges_[fill[cell]++] = static_cast<uint32_t>(edge);
+        });
+    }
+
+    compute_center_winding_numbers();
+    cell_state_.resize(total_cells);
+    for (size_t cell = 0; cell < total_cells; ++cell) {
+        if (cell_offsets_[cell + 1] > cell_offsets_[cell]) {
+            cell_state_[cell] = kBoundary;
+        } else {
+            cell_state_[cell] = center_wn_[cell] != 0 ? kInside : kOutside;
+        }
+    }
+}
+
+int PolygonIndex::cell_row(const double y) const {
+    const double row = std::floor((y - min_.y()) / cell_size_.y());
+    return static_cast<int>(std::max(0.0, std::min(rows_ - 1.0, row)));
+}
+
+int PolygonIndex::cell_col(const double x) const {
+    const double col = std::floor((x - min_.x()) / cell_size_.x());
+    return static_cast<int>(std::max(0.0, std::min(cols_ - 1.0, col)));
+}
+
+Eigen::Vector2d PolygonIndex::cell_center(const int row, const int col) const {
+    return {min_.x() + (col + 0.5) * cell_size_.x(),
+            min_.y() + (row + 0.5) * cell_size_.y()};
+}
+
+const Eigen::Vector2d &PolygonIndex::edge_end(const size_t edge) const {
+    return vertices_[edge + 1 < vertices_.size() ? edge + 1 : 0];
+}
+
+template <typename F>
+void PolygonIndex::for_each_cell_of_edge(const size_t edge, F f) const {
+    for_each_cell_touched_by_edge(
+        vertices_[edge], edge_end(edge), min_, cell_size_, rows_, cols_,
+        margin_, [&](const int row, const int col) {
+            f(static_cast<size_t>(row) * cols_ + col);
+        });
+}
+
+void PolygonIndex::compute_center_winding_numbers() {
+    struct Crossing {
+        int row;
+        double x;
+        int wn;
+    };
+    // Edges crossing the line through the centers of every row, with the
+    // same half open rule as the winding number test.
+    std::vector<Crossing> crossings;
+    for (size_t edge = 0; edge < vertices_.size(); ++edge) {
+        const Eigen::Vector2d &pt1 = vertices_[edge];
+        const Eigen::Vector2d &pt2 = edge_end(edge);
+        for_each_center_row_of_edge(
+            pt1, pt2, min_, cell_size_, rows_,
+            [&](const int row, const double y) {
+                const int wn = edge_crossing_at(pt1, pt2, y);
+                if (wn != 0) {
+                    crossings.push_back({row, edge_x_at(pt1, pt2, y), wn});
+                }
+            });
+    }
+    std::sort(crossings.begin(), crossings.end(),
+              [](const Crossing &a, const Crossing &b) {
+                  return a.row < b.row || (a.row == b.row && a.x < b.x);
+              });
+
+    center_wn_.assign(static_cast<size_t>(rows_) * cols_, 0);
+    auto crossing = crossings.begin();
+    for (int row = 0; row < rows_; ++row) {
+        auto row_end = crossing;
+        int wn = 0;  // Crossings right of the current center.
+        while (row_end != crossings.end() && row_end->row == row) {
+            wn += row_end->wn;
+            ++row_end;
+        }
+        for (int col = 0; col < cols_; ++col) {
+            const Eigen::Vector2d center = cell_center(row, col);
+            while (crossing != row_end && crossing->x <= center.x()) {
+                wn -= crossing->wn;
+                ++crossing;
+            }
+            // The comparison of the crossing with the center is only rounded
+            // for the edges close to the center, which are those of the cell.
+            // They are tested again as in is_point_inside_polygon.
+            const size_t cell = static_cast<size_t>(row) * cols_ + col;
+            int center_wn = wn;
+            for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1];
+                 ++i) {
+                const Eigen::Vector2d &pt1 = vertices_[cell_edges_[i]];
+                const Eigen::Vector2d &pt2 = edge_end(cell_edges_[i]);
+                const double point_in_line =
+                    substitute_point_in_line(pt1, pt2, center);
+                if (is_point_on_segment(pt1, pt2, center, point_in_line)) {
+                    center_wn = kCenterOnPolygon;
+                    break;
+                }
+                const int crossing_wn = edge_crossing_at(pt1, pt2, center.y());
+                if (crossing_wn != 0 &&
+                    edge_x_at(pt1, pt2, center.y()) > center.x()) {
+                    center_wn -= crossing_wn;
+                }
+                center_wn +=
+                    horizontal_crossing(pt1, pt2, center, point_in_line);
+            }
+            center_wn_[cell] = center_wn;
+        }
+        crossing = row_end;
+    }
+}
+
+int PolygonIndex::is_point_inside(const Eigen::Vector2d &query_point) const {
+    if (convex_) {
+        return convex_->is_point_inside(query_point);
+    }
+    // No point outside the bounding box of the vertices is on or inside the
+    // polygon.
+    if (vertices_.empty() || (query_point.array() < min_.array()).any() ||
+        (query_point.array() > max_.array()).any()) {
+        return -1;
+    }
+    const int row = cell_row(query_point.y());
+    const int col = cell_col(query_point.x());
+    const size_t cell = static_cast<size_t>(row) * cols_ + col;
+    if (cell_state_[cell] != kBoundary) {
+        return cell_state_[cell];
+    }
+    // Path from the center down or up to the height of the point, then
+    // across to the point. Only the edges of the cell can cross it.
+    const Eigen::Vector2d center = cell_center(row, col);
+    const Eigen::Vector2d corner(center.x(), query_point.y());
+    int wn = center_wn_[cell];
+    bool corner_on_polygon = false;
+    for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+        const Eigen::Vector2d &pt1 = vertices_[cell_edges_[i]];
+        const Eigen::Vector2d &pt2 = edge_end(cell_edges_[i]);
+        const double query_in_line =
+            substitute_point_in_line(pt1, pt2, query_point);
+        if (is_point_on_segment(pt1, pt2, query_point, query_in_line)) {
+            return 0;
+        }
+        const double corner_in_line =
+            substitute_point_in_line(pt1, pt2, corner);
+        const double center_in_line =
+            substitute_point_in_line(pt1, pt2, center);
+        corner_on_polygon |=
+            is_point_on_segment(pt1, pt2, corner, corner_in_line);
+        wn += vertical_crossing(pt1, pt2, corner, corner_in_line) -
+              vertical_crossing(pt1, pt2, center, center_in_line);
+        wn += horizontal_crossing(pt1, pt2, query_point, query_in_line) -
+              horizontal_crossing(pt1, pt2, corner, corner_in_line);
+    }
+    // The winding number is not defined on the polygon, the path cannot go
+    // through it. Such points are tested against all the edges.
+    if (corner_on_polygon || center_wn_[cell] == kCenterOnPolygon) {
+        return is_point_inside_polygon(query_point, vertices_);
+    }
+    return (wn != 0) ? 1 : -1;
+}
@@ -0,0 +1,205 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Find which of many polygons contain a point, testing only the
+ *        polygons whose bounding box holds it.
+ *
+ */
+
+#include "Point_In_Polygon/polygon_rtree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "Point_In_Polygon/parallel.h"
+#include "Point_In_Polygon/point_in_polygon.h"
+
+namespace {
+// Smallest number of points given to a thread.
+constexpr size_t kMinPointsPerThread = 256;
+// Bounds of the number of children of a node.
+constexpr int kMinNodeCapacity = 2;
+constexpr int kMaxNodeCapacity = 64;
+// Deepest tree, the number of boxes fits in 32 bits and a node has at least
+// 2 children.
+constexpr size_t kMaxDepth = 32;
+}  // namespace
+
+PolygonRTree::PolygonRTree(
+    const std::vector<std::vector<Eigen::Vector2d>> &polygons,
+    const int node_capacity)
+    : node_capacity_(std::max(kMinNodeCapacity,
+                              std::min(kMaxNodeCapacity, node_capacity))),
+      polygons_(polygons) {
+    if (polygons_.empty()) {
+        return;
+    }
+    convex_of_polygon_.assign(polygons_.size(), -1);
+    for (size_t i = 0; i < polygons_.size(); ++i) {
+        if (is_convex_polygon(polygons_[i])) {
+            convex_of_polygon_[i] =
+                static_cast<int32_t>(convex_polygons_.size());
+            convex_polygons_.emplace_back(polygons_[i]);
+        }
+    }
+    // The box of a polygon without vertices holds no point.
+    std::vector<Box> polygon_boxes(polygons_.size());
+    for (size_t i = 0; i < polygons_.size(); ++i) {
+        Box box{std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity(),
+                -std::numeric_limits<double>::infinity()};
+        for (const auto &vertex : polygons_[i]) {
+            box.min_x = std::min(box.min_x, vertex.x());
+            box.min_y = std::min(box.min_y, vertex.y());
+            box.max_x = std::max(box.max_x, vertex.x());
+            box.max_y = std::max(box.max_y, vertex.y());
+        }
+        polygon_boxes[i] = box;
+    }
+    const std::vector<uint32_t> order = packing_order(polygon_boxes);
+    for (const uint32_t polygon : order) {
+        boxes_.push_back(polygon_boxes[polygon]);
+        polygon_of_box_.push_back(static_cast<int32_t>(polygon));
+    }
+
+    // Every level groups the nodes of the level below, already in packing
+    // order, then is sorted in packing order for the next one.
+    size_t level_begin = 0;
+    size_t level_end = boxes_.size();
+    while (level_end - level_begin > 1) {
+        std::vector<Box> node_boxes;
+        std::vector<Children> node_children;
+        for (size_t begin = level_begin; begin < level_end;
+             begin += node_capacity_) {
+            const size_t end = std::min(level_end, begin + node_capacity_);
+            Box box = boxes_[begin];
+            for (size_t child = begin + 1; child < end; ++child) {
+                box.min_x = std::min(box.min_x, boxes_[child].min_x);
+                box.min_y = std::min(box.min_y, boxes_[child].min_y);
+                box.max_x = std::max(box.max_x, boxes_[child].max_x);
+                box.max_y = std::max(box.max_y, boxes_[child].max_y);
+            }
+            node_boxes.push_back(box);
+            node_children.push_back(
+                {static_cast<uint32_t>(begin), static_cast<uint32_t>(end)});
+        }
+        for (const uint32_t node : packing_order(node_boxes)) {
+            boxes_.push_back(node_boxes[node]);
+            children_.push_back(node_children[node]);
+        }
+        level_begin = level_end;
+        level_end = boxes_.size();
+    }
+}
+
+std::vector<uint32_t> PolygonRTree::packing_order(
+    const std::vector<Box> &boxes) const {
+    std::vector<uint32_t> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Boxes without a center, of polygons without vertices, go last.
+    auto center_x = [&boxes](const uint32_t i) {
+        return std::isfinite(boxes[i].min_x)
+                   ? boxes[i].min_x + boxes[i].max_x
+                   : std::numeric_limits<double>::infinity();
+    };
+    auto center_y = [&boxes](const uint32_t i) {
+        return std::isfinite(boxes[i].min_y)
+                   ? boxes[i].min_y + boxes[i].max_y
+                   : std::numeric_limits<double>::infinity();
+    };
+    std::sort(order.begin(), order.end(),
+              [&](const uint32_t a, const uint32_t b) {
+                  return center_x(a) < center_x(b);
+              });
+    const size_t num_nodes =
+        (boxes.size() + node_capacity_ - 1) / node_capacity_;
+    const size_t num_slices = static_cast<size_t>(
+        std::ceil(std::sqrt(static_cast<double>(num_nodes))));
+    const size_t slice_size = num_slices * node_capacity_;
+    for (size_t begin = 0; begin < order.size(); begin += slice_size) {
+        std::sort(order.begin() + begin,
+                  order.begin() + std::min(order.size(), begin + slice_size),
+                  [&](const uint32_t a, const uint32_t b) {
+                      return center_y(a) < center_y(b);
+                  });
+    }
+    return order;
+}
+
+template <typename F>
+void PolygonRTree::for_each_candidate(const Eigen::Vector2d &query_point,
+                                      F f) const {
+    if (boxes_.empty()) {
+        return;
+    }
+    // Depth first, every level leaves at most a node's children on the
+    // stack.
+    uint32_t stack[kMaxDepth * kMaxNodeCapacity];
+    size_t stack_size = 0;
+    stack[stack_size++] = static_cast<uint32_t>(boxes_.size() - 1);
+    const size_t num_polygons = polygons_.size();
+    while (stack_size > 0) {
+        const uint32_t node = stack[--stack_size];
+        if (!boxes_[node].contains(query_point)) {
+            continue;
+        }
+        if (node < num_polygons) {
+            f(polygon_of_box_[node]);
+            continue;
+        }
+        const Children &children = children_[node - num_polygons];
+        for (uint32_t child = children.begin; child < children.end; ++child) {
+            stack[stack_size++] = child;
+        }
+    }
+}
+
+bool PolygonRTree::contains(const int32_t polygon,
+                            const Eigen::Vector2d &query_point) const {
+    const int32_t convex = convex_of_polygon_[polygon];
+    if (convex >= 0) {
+        return convex_polygons_[convex].is_point_inside(query_point) >= 0;
+    }
+    return is_point_inside_polygon(query_point, polygons_[polygon]) >= 0;
+}
+
+int32_t PolygonRTree::find_polygon(const Eigen::Vector2d &query_point) const {
+    int32_t first = -1;
+    for_each_candidate(query_point, [&](const int32_t polygon) {
+        if ((first == -1 || polygon < first) &&
+            contains(polygon, query_point)) {
+            first = polygon;
+        }
+    });
+    return first;
+}
+
+void PolygonRTree::find_polygons(const Eigen::Vector2d &query_point,
+                                 std::vector<int32_t> *polygon_ids) const {
+    polygon_ids->clear();
+    for_each_candidate(query_point, [&](const int32_t polygon) {
+        if (contains(polygon, query_point)) {
+            polygon_ids->push_back(polygon);
+        }
+    });
+    std::sort(polygon_ids->begin(), polygon_ids->end());
+}
+
+void PolygonRTree::find_polygon(const double *xs, const double *ys,
+                                const size_t num_points,
+                                int32_t *polygon_ids,
+                                const int num_threads) const {
+    parallel_for(num_points, num_threads, kMinPointsPerThread,
+                 [&](const size_t begin, const size_t end) {
+                     for (size_t i = begin; i < end; ++i) {
+                         polygon_ids[i] = find_polygon({xs[i], ys[i]});
+                     }
+                 });
+}
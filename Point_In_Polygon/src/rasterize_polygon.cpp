@@ -0,0 +1,182 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Fill a grid with the cells inside, on or outside a polygon, a row of
+ *        cells at a time instead of a query per cell.
+ *
+ */
+
+#include "Point_In_Polygon/rasterize_polygon.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Point_In_Polygon/point_in_polygon.h"
+#include "Point_In_Polygon/polygon_grid.h"
+
+namespace {
+struct Crossing {
+    double x;
+    int wn;
+};
+}  // namespace
+
+void rasterize_polygon(const std::vector<Eigen::Vector2d> &vertices,
+                       const RasterGrid &grid, std::vector<int8_t> *mask,
+                       const FillRule fill_rule,
+                       const bool mark_boundary_cells) {
+    const int rows = std::max(grid.rows, 0);
+    const int cols = std::max(grid.cols, 0);
+    mask->assign(static_cast<size_t>(rows) * cols, -1);
+    const size_t num_edges = vertices.size();
+    if (num_edges == 0 || rows == 0 || cols == 0) {
+        return;
+    }
+    const double cell_size = grid.cell_size;
+    const Eigen::Vector2d cell_sizes(cell_size, cell_size);
+    auto edge_end = [&](const size_t edge) -> const Eigen::Vector2d & {
+        return vertices[edge + 1 < num_edges ? edge + 1 : 0];
+    };
+    auto center_x = [&](const int col) { return grid.cell_center(0, col).x(); };
+    auto center_y = [&](const int row) { return grid.cell_center(row, 0).y(); };
+
+    // Rows whose line of centers meets the edge, ends included.
+    auto for_each_row_of_edge = [&](const size_t edge, auto f) {
+        for_each_center_row_of_edge(
+            vertices[edge], edge_end(edge), grid.origin, cell_sizes, rows,
+            [&](const int row, double) { f(row); });
+    };
+
+    // Edges meeting every row, counted then filled.
+    std::vector<uint32_t> row_offsets(rows + 1, 0);
+    for (size_t edge = 0; edge < num_edges; ++edge) {
+        for_each_row_of_edge(edge,
+                             [&](const int row) { ++row_offsets[row + 1]; });
+    }
+    for (int row = 0; row < rows; ++row) {
+        row_offsets[row + 1] += row_offsets[row];
+    }
+    std::vector<uint32_t> row_edges(row_offsets[rows]);
+    std::vector<uint32_t> fill(row_offsets.begin(), row_offsets.end() - 1);
+    for (size_t edge = 0; edge < num_edges; ++edge) {
+        for_each_row_of_edge(edge, [&](const int row) {
+            row_edges[fill[row]++] = static_cast<uint32_t>(edge);
+        });
+    }
+
+    std::vector<Crossing> crossings;
+    std::vector<int> wn(cols);
+    std::vector<int> num_crossings(cols);
+    std::vector<uint8_t> on_polygon(cols);
+    for (int row = 0; row < rows; ++row) {
+        const double y = center_y(row);
+        // Edges crossing the line of centers, with the same half open rule as
+        // the winding number test.
+        crossings.clear();
+        for (uint32_t i = row_offsets[row]; i < row_offsets[row + 1]; ++i) {
+            const Eigen::Vector2d &pt1 = vertices[row_edges[i]];
+            const Eigen::Vector2d &pt2 = edge_end(row_edges[i]);
+            const int crossing_wn = edge_crossing_at(pt1, pt2, y);
+            if (crossing_wn != 0) {
+                crossings.push_back({edge_x_at(pt1, pt2, y), crossing_wn});
+            }
+        }
+        std::sort(crossings.begin(), crossings.end(),
+                  [](const Crossing &a, const Crossing &b) {
+                      return a.x < b.x;
+                  });
+
+        // Crossings right of every center, going left to right.
+        int row_wn = 0;
+        for (const auto &crossing : crossings) {
+            row_wn += crossing.wn;
+        }
+        int row_crossings = static_cast<int>(crossings.size());
+        auto crossing = crossings.begin();
+        for (int col = 0; col < cols; ++col) {
+            const double x = center_x(col);
+            while (crossing != crossings.end() && crossing->x <= x) {
+                row_wn -= crossing->wn;
+                --row_crossings;
+                ++crossing;
+            }
+            wn[col] = row_wn;
+            num_crossings[col] = row_crossings;
+        }
+        std::fill(on_polygon.begin(), on_polygon.end(), 0);
+
+        // The comparison of a crossing with a center is only rounded for the
+        // few centers next to it. They are tested again as in
+        // is_point_inside_polygon, which also finds the centers on an edge.
+        for (uint32_t i = row_offsets[row]; i < row_offsets[row + 1]; ++i) {
+            const Eigen::Vector2d &pt1 = vertices[row_edges[i]];
+            const Eigen::Vector2d &pt2 = edge_end(row_edges[i]);
+            if (pt1.y() == pt2.y()) {
+                // Along the line of centers, only the ones on it matter.
+                const double x_min = std::min(pt1.x(), pt2.x());
+                const double x_max = std::max(pt1.x(), pt2.x());
+                const int first_col = std::max(
+                    0,
+                    clamped_cell((x_min - grid.origin.x()) / cell_size - 0.5,
+                                 cols));
+                const int last_col = std::min(
+                    cols - 1,
+                    clamped_cell((x_max - grid.origin.x()) / cell_size - 0.5,
+                                 cols) +
+                        1);
+                for (int col = first_col; col <= last_col; ++col) {
+                    const double x = center_x(col);
+                    on_polygon[col] |= x_min <= x && x <= x_max;
+                }
+                continue;
+            }
+            const int crossing_wn = edge_crossing_at(pt1, pt2, y);
+            const double edge_x = edge_x_at(pt1, pt2, y);
+            const int nearest_col = clamped_cell(
+                (edge_x - grid.origin.x()) / cell_size - 0.5, cols);
+            const int first_col = std::max(0, nearest_col - 1);
+            const int last_col = std::min(cols - 1, nearest_col + 2);
+            for (int col = first_col; col <= last_col; ++col) {
+                const Eigen::Vector2d center(center_x(col), y);
+                const double point_in_line =
+                    substitute_point_in_line(pt1, pt2, center);
+                if (point_in_line == 0 &&
+                    is_point_within_segment_bounds(pt1, pt2, center)) {
+                    on_polygon[col] = 1;
+                }
+                if (crossing_wn == 0) {
+                    continue;
+                }
+                const int counted = edge_x > center.x();
+                const int exact = crossing_wn > 0 ? point_in_line > 0
+                                                  : point_in_line < 0;
+                wn[col] += crossing_wn * (exact - counted);
+                num_crossings[col] += exact - counted;
+            }
+        }
+
+        int8_t *row_mask = mask->data() + static_cast<size_t>(row) * cols;
+        for (int col = 0; col < cols; ++col) {
+            const bool inside = fill_rule == FillRule::kNonZero
+                                    ? wn[col] != 0
+                                    : (num_crossings[col] & 1) != 0;
+            row_mask[col] = on_polygon[col] ? 0 : (inside ? 1 : -1);
+        }
+    }
+
+    if (!mark_boundary_cells) {
+        return;
+    }
+    // Cells touched by every edge, row by row along the edge.
+    for (size_t edge = 0; edge < num_edges; ++edge) {
+        for_each_cell_touched_by_edge(
+            vertices[edge], edge_end(edge), grid.origin, cell_sizes, rows,
+            cols, 0.0, [&](const int row, const int col) {
+                (*mask)[static_cast<size_t>(row) * cols + col] = 0;
+            });
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-08
+ * Last Edit Date: 2020-08
+ *
+ * @brief Orientation of a point relative to a line with an exact sign, using
+ *        floating point arithmetic when its result is certain and exact
+ *        arithmetic only when it is not.
+ *
+ */
+
+#include "Point_In_Polygon/robust_predicates.h"
+
+#include <cstddef>
+
+namespace {
+/**
+ * @brief a + b = sum + error exactly.
+ *
+ */
+void two_sum(const double a, const double b, double *sum, double *error) {
+    *sum = a + b;
+    const double b_virtual = *sum - a;
+    const double a_virtual = *sum - b_virtual;
+    *error = (a - a_virtual) + (b - b_virtual);
+}
+
+/**
+ * @brief a * b = product + error exactly.
+ *
+ */
+void two_product(const double a, const double b, double *product,
+                 double *error) {
+    *product = a * b;
+    *error = std::fma(a, b, -*product);
+}
+
+/**
+ * @brief Add b to the expansion e of size components, the components of an
+ *        expansion being non overlapping and of increasing magnitude. e gets
+ *        one more component.
+ *
+ */
+void grow_expansion(double *e, const size_t size, const double b) {
+    double q = b;
+    for (size_t i = 0; i < size; ++i) {
+        two_sum(q, e[i], &q, &e[i]);
+    }
+    e[size] = q;
+}
+}  // namespace
+
+double orientation_exact(const double x1, const double y1, const double x2,
+                         const double y2, const double qx, const double qy) {
+    // (x2 - x1) * (qy - y1) - (y2 - y1) * (qx - x1) expanded, the differences
+    // are not exact but the products of the coordinates are. The x1 * y1
+    // terms cancel out.
+    const double factors[6][2] = {{x2, qy},  {-x2, y1}, {-x1, qy},
+                                  {-y2, qx}, {y2, x1},  {y1, qx}};
+    double expansion[12];
+    size_t size = 0;
+    for (const auto &factor : factors) {
+        double product;
+        double error;
+        two_product(factor[0], factor[1], &product, &error);
+        grow_expansion(expansion, size++, error);
+        grow_expansion(expansion, size++, product);
+    }
+    // The largest non zero component gives the sign, the sum from the
+    // smallest component up is close to the exact value.
+    double value = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        value += expansion[i];
+    }
+    for (size_t i = size; i-- > 0;) {
+        if (expansion[i] != 0) {
+            return (expansion[i] > 0) == (value > 0) ? value : expansion[i];
+        }
+    }
+    return 0.0;
+}
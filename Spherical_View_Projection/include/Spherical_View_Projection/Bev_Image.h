@@ -0,0 +1,117 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Bird's eye view grid of a point cloud, made in the same pass as the
+ * spherical projection. All the planes live in one contiguous float buffer:
+ * the maximum height of every height slice, the density and the intensity.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_BEV_IMAGE_H_
+#define SPHERICAL_VIEW_PROJECTION_BEV_IMAGE_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Extent and resolution of the bird's eye view. Row 0 is the farthest
+ * cells ahead of the lidar (x_max) and column 0 the farthest on its left
+ * (y_max), as seen from above.
+ *
+ */
+struct BevConfig {
+  /**
+   * @brief Whether MakeImage also makes the bird's eye view.
+   *
+   */
+  bool enabled = false;
+  /**
+   * @brief Area covered by the grid in the lidar frame (meters).
+   *
+   */
+  float x_min = 0.0f;
+  float x_max = 70.0f;
+  float y_min = -40.0f;
+  float y_max = 40.0f;
+  /**
+   * @brief Side of a cell (meters).
+   *
+   */
+  float cell_size = 0.1f;
+  /**
+   * @brief Increasing heights (meters) separating the height slices, the
+   * points below the first or above the last one are ignored. N heights make
+   * N - 1 slices.
+   *
+   */
+  std::vector<float> height_slices{-2.0f, -1.0f, 0.0f, 1.0f};
+};
+
+class BevImage {
+ public:
+  BevImage() = default;
+  /**
+   * @brief Allocate a grid with all the values set to 0.
+   *
+   * @param[in] rows number of cells along x
+   * @param[in] cols number of cells along y
+   * @param[in] num_slices number of height slices
+   */
+  BevImage(const int rows, const int cols, const int num_slices)
+      : rows_(rows), cols_(cols), num_slices_(num_slices) {
+    data_.assign(PlaneSize() * NumPlanes(), 0.0f);
+  }
+
+  int Rows() const { return rows_; }
+  int Cols() const { return cols_; }
+  int NumSlices() const { return num_slices_; }
+  /**
+   * @brief Number of planes, a height plane per slice then the density and
+   * intensity planes.
+   *
+   */
+  int NumPlanes() const { return num_slices_ + 2; }
+  size_t PlaneSize() const { return static_cast<size_t>(rows_) * cols_; }
+  /**
+   * @brief Height of the highest point of every cell in a slice, above the
+   * bottom of the slice. 0 when the slice of the cell is empty.
+   *
+   */
+  float* HeightPlane(const int slice) {
+    return data_.data() + slice * PlaneSize();
+  }
+  const float* HeightPlane(const int slice) const {
+    return data_.data() + slice * PlaneSize();
+  }
+  /**
+   * @brief Density of the points of every cell, min(1, log(N + 1) / log(64))
+   * for N points as in MV3D.
+   *
+   */
+  float* DensityPlane() { return HeightPlane(num_slices_); }
+  const float* DensityPlane() const { return HeightPlane(num_slices_); }
+  /**
+   * @brief Intensity of the highest point of every cell.
+   *
+   */
+  float* IntensityPlane() { return HeightPlane(num_slices_ + 1); }
+  const float* IntensityPlane() const { return HeightPlane(num_slices_ + 1); }
+  /**
+   * @brief The whole buffer, planes one after the other.
+   *
+   */
+  float* Data() { return data_.data(); }
+  const float* Data() const { return data_.data(); }
+  size_t Size() const { return data_.size(); }
+
+ private:
+  int rows_ = 0;
+  int cols_ = 0;
+  int num_slices_ = 0;
+  std::vector<float> data_;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_BEV_IMAGE_H_
@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Branch free polynomial approximations of the trigonometric functions
+ * used by the spherical projection. They are written so that the compiler can
+ * vectorize a loop calling them, which the libm versions prevent.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_FAST_MATH_H_
+#define SPHERICAL_VIEW_PROJECTION_FAST_MATH_H_
+
+#include <cmath>
+
+/**
+ * @brief Approximation of atan2(y, x).
+ *
+ * Uses the polynomial 4.4.49 of Abramowitz and Stegun on [0, 1] and folds the
+ * remaining octants onto it. The absolute error in float is below 2e-5 rad,
+ * which is far below the angular size of a pixel for any practical image
+ * length.
+ *
+ * @param[in] y
+ * @param[in] x
+ * @return angle in radians in [-pi, pi]
+ */
+inline float FastAtan2(const float y, const float x) {
+  const float abs_x = std::fabs(x);
+  const float abs_y = std::fabs(y);
+  const float max_xy = abs_x > abs_y ? abs_x : abs_y;
+  const float min_xy = abs_x > abs_y ? abs_y : abs_x;
+  // Avoid 0 / 0 at the origin, atan2(0, 0) is taken as 0.
+  const float t = min_xy / (max_xy > 0.0f ? max_xy : 1.0f);
+  const float t2 = t * t;
+  float angle =
+      t * (0.9998660f +
+           t2 * (-0.3302995f +
+                 t2 * (0.1801410f + t2 * (-0.0851330f + t2 * 0.0208351f))));
+  angle = abs_y > abs_x ? static_cast<float>(M_PI_2) - angle : angle;
+  angle = x < 0.0f ? static_cast<float>(M_PI) - angle : angle;
+  return y < 0.0f ? -angle : angle;
+}
+
+/**
+ * @brief Approximation of asin(x).
+ *
+ * Uses the polynomial 4.4.46 of Abramowitz and Stegun, whose error is below
+ * 2e-8 rad on [0, 1], so the result is limited by float precision (below 1e-6
+ * rad). Inputs outside [-1, 1] are clamped.
+ *
+ * @param[in] x
+ * @return angle in radians in [-pi/2, pi/2]
+ */
+inline float FastAsin(const float x) {
+  float abs_x = std::fabs(x);
+  abs_x = abs_x < 1.0f ? abs_x : 1.0f;
+  const float poly =
+      1.5707963050f +
+      abs_x *
+          (-0.2145988016f +
+           abs_x *
+               (0.0889789874f +
+                abs_x *
+                    (-0.0501743046f +
+                     abs_x *
+                         (0.0308918810f +
+                          abs_x * (-0.0170881256f +
+                                   abs_x * (0.0066700901f +
+                                            abs_x * -0.0012624911f))))));
+  const float angle =
+      static_cast<float>(M_PI_2) - std::sqrt(1.0f - abs_x) * poly;
+  return x < 0.0f ? -angle : angle;
+}
+
+#endif  // SPHERICAL_VIEW_PROJECTION_FAST_MATH_H_
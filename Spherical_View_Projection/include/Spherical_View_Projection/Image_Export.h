@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Write projection images to disk without a display, as 16 bit PNG
+ * images or raw float32 planes.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_IMAGE_EXPORT_H_
+#define SPHERICAL_VIEW_PROJECTION_IMAGE_EXPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Spherical_View_Projection/Spherical_Image.h"
+
+/**
+ * @brief File format of the exported images.
+ *
+ */
+enum class ExportFormat : uint8_t {
+  /**
+   * @brief <prefix>_range.png and <prefix>_intensity.png, 16 bit single
+   * channel images holding the value times its scale.
+   *
+   */
+  kPng16,
+  /**
+   * @brief <prefix>.bin, every plane of the image as float32 in (channel,
+   * row, col) order, exactly as in memory.
+   *
+   */
+  kRaw,
+};
+
+/**
+ * @brief Configuration of the export.
+ *
+ */
+struct ExportConfig {
+  ExportFormat format = ExportFormat::kPng16;
+  /**
+   * @brief Scale of the range in the PNG images, 256 stores 1/256 m steps up
+   * to 256 m as in the KITTI depth maps.
+   *
+   */
+  float range_scale = 256.0f;
+  /**
+   * @brief Scale of the intensity in the PNG images, 256 for 0 to 255
+   * intensities, 65535 for the 0 to 1 KITTI reflectances.
+   *
+   */
+  float intensity_scale = 256.0f;
+};
+
+class ImageExporter {
+ public:
+  /**
+   * @brief Constructor to set the configuration.
+   *
+   * @param[in] config configuration of the export
+   */
+  ImageExporter(const ExportConfig& config);
+  /**
+   * @brief Write the image in the configured format. Channels missing from the
+   * image are not written.
+   *
+   * @param[in] image the projection image
+   * @param[in] prefix path of the files without the suffix and extension
+   * @return -1 A file cannot be written
+   * @return 1 image written successfully
+   */
+  int Export(const SphericalImage& image, const std::string& prefix);
+  /**
+   * @brief Convert values to 16 bit, rounding value * scale and clamping it
+   * to [0, 65535]. Runs on several values per instruction.
+   *
+   * @param[in] values the values to convert
+   * @param[in] size number of values
+   * @param[in] scale scale of the values
+   * @param[out] converted size converted values
+   */
+  static void ToUInt16(const float* values, size_t size, float scale,
+                       uint16_t* converted);
+
+ private:
+  /**
+   * @brief Write one channel of the image as a 16 bit PNG.
+   *
+   */
+  int WritePng16(const SphericalImage& image, Channel channel, float scale,
+                 const std::string& path);
+  /**
+   * @brief Write all the planes of the image as float32.
+   *
+   */
+  int WriteRaw(const SphericalImage& image, const std::string& path) const;
+  /**
+   * @brief The configuration of the export
+   *
+   */
+  const ExportConfig config_;
+  /**
+   * @brief Converted plane, reused from image to image.
+   *
+   */
+  std::vector<uint16_t> converted_;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_IMAGE_EXPORT_H_
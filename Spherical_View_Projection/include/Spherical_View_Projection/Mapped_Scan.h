@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Memory mapped lidar scan stored as raw float32 x, y, z, intensity
+ * values, as in the KITTI velodyne .bin files. The points are read straight
+ * from the page cache, nothing is parsed or copied.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_MAPPED_SCAN_H_
+#define SPHERICAL_VIEW_PROJECTION_MAPPED_SCAN_H_
+
+#include <cstddef>
+#include <string>
+
+#include "Spherical_View_Projection/Point_View.h"
+
+class MappedScan {
+ public:
+  MappedScan() = default;
+  ~MappedScan();
+  MappedScan(const MappedScan&) = delete;
+  MappedScan& operator=(const MappedScan&) = delete;
+  /**
+   * @brief Map a .bin scan, unmapping the previous one. If the new scan
+   * cannot be mapped the previous one stays mapped.
+   *
+   * @param[in] path Absolute path to the .bin file
+   * @return -1 The file cannot be mapped or is not made of 4 float points
+   * @return 1 Scan mapped successfully
+   */
+  int Open(const std::string& path);
+  /**
+   * @brief Unmap the scan.
+   *
+   */
+  void Close();
+  /**
+   * @brief View of the mapped points, valid until the scan is closed.
+   *
+   */
+  PointView View() const;
+  size_t size() const { return num_points_; }
+
+ private:
+  void* data_ = nullptr;
+  size_t num_bytes_ = 0;
+  size_t num_points_ = 0;
+};
+
+/**
+ * @brief Write a synthetic .bin scan with one point per beam of a lidar
+ * standing 1.73 m above flat ground, inside a wavy wall, to run without a
+ * recorded scan.
+ *
+ * @param[in] path Absolute path to the .bin file
+ * @param[in] fov_up upper field of view of the lidar (degrees)
+ * @param[in] fov_down lower field of view of the lidar (degrees)
+ * @param[in] num_lasers number of beams from fov_up to fov_down
+ * @param[in] num_columns number of beams around the lidar
+ * @return -1 The file cannot be written
+ * @return 1 Scan written successfully
+ */
+int WriteSyntheticScan(const std::string& path, double fov_up, double fov_down,
+                       int num_lasers, int num_columns);
+
+#endif  // SPHERICAL_VIEW_PROJECTION_MAPPED_SCAN_H_
@@ -0,0 +1,281 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Small helpers to split a loop over several threads, either started
+ * for the loop or kept in a pool.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_PARALLEL_H_
+#define SPHERICAL_VIEW_PROJECTION_PARALLEL_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Resolve the number of threads to use.
+ *
+ * @param[in] num_threads requested threads, 0 means all hardware threads.
+ * @return int number of threads, at least 1.
+ */
+inline int ResolveNumThreads(const int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Number of chunks ParallelForChunks splits a loop into, one per
+ * thread. Small loops are not split, since starting a thread costs more than
+ * they do.
+ *
+ * @param[in] size number of iterations.
+ * @param[in] num_threads requested threads, 0 means all hardware threads.
+ * @param[in] min_chunk fewest iterations worth a thread, lower for loops
+ * whose iterations do a lot of work each.
+ * @return size_t number of chunks, at least 1.
+ */
+inline size_t NumParallelChunks(const size_t size, const int num_threads,
+                                const size_t min_chunk = 4096) {
+  const size_t max_threads =
+      std::max<size_t>(1, size / std::max<size_t>(1, min_chunk));
+  return std::min<size_t>(ResolveNumThreads(num_threads), max_threads);
+}
+
+/**
+ * @brief Call function(chunk, begin, end) on NumParallelChunks contiguous
+ * chunks of [0, size), one chunk per thread. The chunks only depend on size
+ * and num_threads, so two loops can share per chunk results. The calling
+ * thread processes the first chunk.
+ *
+ * @param[in] size number of iterations.
+ * @param[in] num_threads requested threads, 0 means all hardware threads.
+ * @param[in] function callable taking (size_t chunk, size_t begin, size_t
+ * end).
+ * @param[in] min_chunk fewest iterations worth a thread, see
+ * NumParallelChunks.
+ */
+template <typename Function>
+void ParallelForChunks(const size_t size, const int num_threads,
+                       const Function& function,
+                       const size_t min_chunk = 4096) {
+  const size_t threads = NumParallelChunks(size, num_threads, min_chunk);
+  if (threads <= 1) {
+    function(size_t{0}, size_t{0}, size);
+    return;
+  }
+  const size_t chunk = (size + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) {
+    const size_t begin = std::min(size, t * chunk);
+    const size_t end = std::min(size, begin + chunk);
+    workers.emplace_back(
+        [&function, t, begin, end]() { function(t, begin, end); });
+  }
+  function(size_t{0}, size_t{0}, std::min(size, chunk));
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @brief Call function(begin, end) on contiguous chunks of [0, size), one chunk
+ * per thread, see ParallelForChunks.
+ *
+ * @param[in] size number of iterations.
+ * @param[in] num_threads requested threads, 0 means all hardware threads.
+ * @param[in] function callable taking (size_t begin, size_t end).
+ * @param[in] min_chunk fewest iterations worth a thread, see
+ * NumParallelChunks.
+ */
+template <typename Function>
+void ParallelFor(const size_t size, const int num_threads,
+                 const Function& function, const size_t min_chunk = 4096) {
+  ParallelForChunks(
+      size, num_threads,
+      [&function](const size_t, const size_t begin, const size_t end) {
+        function(begin, end);
+      },
+      min_chunk);
+}
+
+/**
+ * @brief Threads started once and reused by every loop, for objects running
+ * several short loops per call where starting threads for each would cost
+ * more than the loops. The loops are split as by ParallelForChunks. Loops
+ * started from several threads run one after the other.
+ *
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Start the worker threads, the calling thread of every loop being
+   * the last one.
+   *
+   * @param[in] num_threads requested threads, 0 means all hardware threads.
+   */
+  explicit ThreadPool(const int num_threads) {
+    const int threads = ResolveNumThreads(num_threads);
+    workers_.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) {
+      workers_.emplace_back([this, t]() { Work(t); });
+    }
+  }
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int NumThreads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  /**
+   * @brief Same as ParallelForChunks(size, NumThreads(), function, min_chunk)
+   * on the pool.
+   *
+   * @param[in] size number of iterations.
+   * @param[in] function callable taking (size_t chunk, size_t begin, size_t
+   * end).
+   * @param[in] min_chunk fewest iterations worth a thread, see
+   * NumParallelChunks.
+   */
+  template <typename Function>
+  void ForChunks(const size_t size, const Function& function,
+                 const size_t min_chunk = 4096) {
+    const size_t threads = NumParallelChunks(size, NumThreads(), min_chunk);
+    if (threads <= 1) {
+      function(size_t{0}, size_t{0}, size);
+      return;
+    }
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    const size_t chunk = (size + threads - 1) / threads;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = Job{&function, &CallChunk<Function>, size, chunk, threads};
+      pending_ = threads - 1;
+      ++generation_;
+    }
+    start_.notify_all();
+    function(size_t{0}, size_t{0}, std::min(size, chunk));
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+  }
+
+  /**
+   * @brief Same as ParallelFor(size, NumThreads(), function, min_chunk) on the
+   * pool.
+   *
+   * @param[in] size number of iterations.
+   * @param[in] function callable taking (size_t begin, size_t end).
+   * @param[in] min_chunk fewest iterations worth a thread, see
+   * NumParallelChunks.
+   */
+  template <typename Function>
+  void For(const size_t size, const Function& function,
+           const size_t min_chunk = 4096) {
+    ForChunks(
+        size,
+        [&function](const size_t, const size_t begin, const size_t end) {
+          function(begin, end);
+        },
+        min_chunk);
+  }
+
+ private:
+  /**
+   * @brief The loop being run, the function is called through call so that
+   * it is neither copied nor allocated.
+   *
+   */
+  struct Job {
+    const void* function = nullptr;
+    void (*call)(const void* function, size_t chunk, size_t begin,
+                 size_t end) = nullptr;
+    size_t size = 0;
+    size_t chunk = 0;
+    size_t threads = 0;
+  };
+
+  template <typename Function>
+  static void CallChunk(const void* function, const size_t chunk,
+                        const size_t begin, const size_t end) {
+    (*static_cast<const Function*>(function))(chunk, begin, end);
+  }
+
+  /**
+   * @brief Loop of worker thread t, running chunk t of every loop that has
+   * one.
+   *
+   */
+  void Work(const size_t t) {
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      start_.wait(lock,
+                  [this, generation]() {
+                    return stop_ || generation_ != generation;
+                  });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      const Job job = job_;
+      if (t >= job.threads) {
+        continue;
+      }
+      lock.unlock();
+      const size_t begin = std::min(job.size, t * job.chunk);
+      job.call(job.function, t, begin, std::min(job.size, begin + job.chunk));
+      lock.lock();
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  /**
+   * @brief Held for the whole of a loop, so that loops started from several
+   * threads do not mix.
+   *
+   */
+  std::mutex run_mutex_;
+  /**
+   * @brief Guards job_, pending_, generation_ and stop_.
+   *
+   */
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  Job job_;
+  /**
+   * @brief Number of chunks of the current loop still running on a worker.
+   *
+   */
+  size_t pending_ = 0;
+  /**
+   * @brief Incremented by every loop, a worker runs a loop once.
+   *
+   */
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_PARALLEL_H_
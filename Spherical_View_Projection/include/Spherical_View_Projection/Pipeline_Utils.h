@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Small helpers shared by the projection pipeline, the node and the
+ * benchmark.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_PIPELINE_UTILS_H_
+#define SPHERICAL_VIEW_PROJECTION_PIPELINE_UTILS_H_
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Spherical_View_Projection/Mapped_Scan.h"
+#include "Spherical_View_Projection/Spherical_View_Projection.h"
+
+/**
+ * @brief Seconds elapsed since a point in time.
+ *
+ * @param[in] start time point taken with std::chrono::steady_clock::now().
+ * @return double seconds.
+ */
+inline double SecondsSince(
+    const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * @brief Check if a path is a raw scan in the KITTI .bin format rather than
+ * a .pcd cloud.
+ *
+ * @param[in] path path of the file.
+ * @return true if the path ends with .bin.
+ */
+inline bool IsBinFile(const std::string& path) {
+  const std::string extension = ".bin";
+  return path.size() >= extension.size() &&
+         path.compare(path.size() - extension.size(), extension.size(),
+                      extension) == 0;
+}
+
+/**
+ * @brief Cloud to project when none is given: test_cloud when it exists,
+ * else a synthetic scan of the configured lidar, see WriteSyntheticScan.
+ *
+ * @param[in] test_cloud path of the bundled test cloud.
+ * @param[in] synthetic_path where to write the synthetic scan, ending in .bin.
+ * @param[in] config configuration of the projection.
+ * @return std::string path of the cloud, empty when neither can be used.
+ */
+inline std::string DefaultCloudPath(const std::string& test_cloud,
+                                    const std::string& synthetic_path,
+                                    const Configuration& config) {
+  if (std::ifstream(test_cloud).good()) {
+    return test_cloud;
+  }
+  if (WriteSyntheticScan(synthetic_path, config.fov_up, config.fov_down,
+                         static_cast<int>(config.num_lasers),
+                         static_cast<int>(config.img_length)) == -1) {
+    return "";
+  }
+  std::cout << test_cloud << " is missing, using a synthetic scan written to "
+            << synthetic_path << "\n";
+  return synthetic_path;
+}
+
+#endif  // SPHERICAL_VIEW_PROJECTION_PIPELINE_UTILS_H_
@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Non owning view of the x, y, z and intensity of a set of points, so
+ * that the projection can read a PCL cloud, a memory mapped scan or separate
+ * arrays without copying them.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_POINT_VIEW_H_
+#define SPHERICAL_VIEW_PROJECTION_POINT_VIEW_H_
+
+#include <cstddef>
+
+struct PointView {
+  /**
+   * @brief View of separate arrays, one per value (structure of arrays).
+   *
+   * @param[in] x
+   * @param[in] y
+   * @param[in] z
+   * @param[in] intensity may be null, the points then have intensity 0
+   * @param[in] size number of points in every array
+   */
+  static PointView FromArrays(const float* x, const float* y, const float* z,
+                              const float* intensity, const size_t size) {
+    return PointView{x, y, z, intensity, 1, size};
+  }
+  /**
+   * @brief View of points stored one after the other, starting with x, y, z
+   * and intensity, e.g. the float32 KITTI .bin scans (stride 4).
+   *
+   * @param[in] data the first value of the first point
+   * @param[in] size number of points
+   * @param[in] stride number of floats from one point to the next
+   */
+  static PointView FromInterleaved(const float* data, const size_t size,
+                                   const size_t stride = 4) {
+    return PointView{data, data + 1, data + 2, data + 3, stride, size};
+  }
+
+  float X(const size_t i) const { return x[i * stride]; }
+  float Y(const size_t i) const { return y[i * stride]; }
+  float Z(const size_t i) const { return z[i * stride]; }
+  float Intensity(const size_t i) const {
+    return intensity ? intensity[i * stride] : 0.0f;
+  }
+
+  const float* x = nullptr;
+  const float* y = nullptr;
+  const float* z = nullptr;
+  const float* intensity = nullptr;
+  /**
+   * @brief Number of floats from one point to the next.
+   *
+   */
+  size_t stride = 1;
+  /**
+   * @brief Number of points.
+   *
+   */
+  size_t size = 0;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_POINT_VIEW_H_
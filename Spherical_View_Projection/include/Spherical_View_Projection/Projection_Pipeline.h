@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Pipeline to project a stream of point clouds. Loading frame N + 1,
+ * projecting frame N and consuming frame N - 1 run at the same time on their
+ * own threads, and the clouds and images are reused from frame to frame.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_PROJECTION_PIPELINE_H_
+#define SPHERICAL_VIEW_PROJECTION_PROJECTION_PIPELINE_H_
+
+#include <pcl/point_cloud.h>  // For PCL Point Cloud
+#include <pcl/point_types.h>  // For PCL different cloud types
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Spherical_View_Projection/Bev_Image.h"
+#include "Spherical_View_Projection/Mapped_Scan.h"
+#include "Spherical_View_Projection/Spherical_Image.h"
+#include "Spherical_View_Projection/Spherical_View_Projection.h"
+
+/**
+ * @brief Throughput and mean latency of every stage of a pipeline run.
+ *
+ */
+struct PipelineStats {
+  /**
+   * @brief Number of frames that went through all the stages.
+   *
+   */
+  size_t frames = 0;
+  /**
+   * @brief Frames per second over the whole run.
+   *
+   */
+  double fps = 0.0;
+  /**
+   * @brief Mean time spent in every stage per frame (milliseconds).
+   *
+   */
+  double load_ms = 0.0;
+  double project_ms = 0.0;
+  double consume_ms = 0.0;
+};
+
+class ProjectionPipeline {
+ public:
+  /**
+   * @brief Called on the thread running the pipeline for every projected
+   * frame. The image and the bird's eye view, empty when config.bev.enabled
+   * is not set, are only valid during the call.
+   *
+   */
+  using Consumer = std::function<void(
+      size_t frame, const SphericalImage& image, const BevImage& bev)>;
+
+  /**
+   * @brief Constructor allocating the reusable buffers.
+   *
+   * @param[in] config configuration of the projection
+   * @param[in] num_buffers number of cloud and image buffers in flight, at
+   * least 3 so that every stage has one.
+   */
+  ProjectionPipeline(const Configuration& config, int num_buffers = 3);
+  /**
+   * @brief Load, project and consume the files in order. Files ending in .bin
+   * are memory mapped as KITTI scans, the others are read as .pcd. Files that
+   * cannot be read are skipped.
+   *
+   * @param[in] paths Absolute paths to the .pcd or .bin files
+   * @param[in] consume called for every projected frame
+   * @return PipelineStats
+   */
+  PipelineStats Run(const std::vector<std::string>& paths,
+                    const Consumer& consume);
+
+ private:
+  /**
+   * @brief A cloud and its images, passed from stage to stage.
+   *
+   */
+  struct Frame {
+    size_t index = 0;
+    /**
+     * @brief Whether the points are in scan rather than cloud.
+     *
+     */
+    bool is_scan = false;
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    MappedScan scan;
+    SphericalImage image;
+    BevImage bev;
+  };
+  /**
+   * @brief Projects the frames, only used by the projection stage.
+   *
+   */
+  SphericalConversion conv_;
+  std::vector<Frame> frames_;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_PROJECTION_PIPELINE_H_
@@ -0,0 +1,171 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Geometry computed directly on the spherical projection image. The
+ * neighbors of a point are the points of the pixels around its own, so
+ * neighbor search, surface normals and ground segmentation need no k-d tree.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_RANGE_IMAGE_GEOMETRY_H_
+#define SPHERICAL_VIEW_PROJECTION_RANGE_IMAGE_GEOMETRY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Spherical_View_Projection/Spherical_Image.h"
+
+/**
+ * @brief Configuration of the geometry computed on the image.
+ *
+ */
+struct GeometryConfig {
+  /**
+   * @brief Neighbors are searched in the pixels at most half_window_rows rows
+   * and half_window_cols columns away from the query pixel. The columns wrap
+   * around, the image covering 360 degrees.
+   *
+   */
+  int half_window_rows = 2;
+  int half_window_cols = 4;
+  /**
+   * @brief Neighbors whose range differs from the range of the pixel by more
+   * than this ratio of it are on another surface, and are not used for the
+   * normals.
+   *
+   */
+  float max_range_jump = 0.1f;
+  /**
+   * @brief Height of the lidar above the ground (meters), 1.73 on the KITTI
+   * car.
+   *
+   */
+  float sensor_height = 1.73f;
+  /**
+   * @brief Largest slope between consecutive ground points of a column
+   * (degrees).
+   *
+   */
+  float max_ground_slope = 10.0f;
+  /**
+   * @brief The number of threads used. 0 uses all the hardware threads.
+   *
+   */
+  int num_threads = 0;
+};
+
+/**
+ * @brief A neighbor found in the image.
+ *
+ */
+struct Neighbor {
+  /**
+   * @brief Pixel index (row * cols + col) of the neighbor.
+   *
+   */
+  int32_t pixel = -1;
+  /**
+   * @brief Squared distance to the query point.
+   *
+   */
+  float distance_sq = 0.0f;
+};
+
+/**
+ * @brief Unit normal of every pixel, one plane per component, row major. The
+ * normals point towards the lidar and are 0 where they cannot be computed.
+ *
+ */
+struct NormalMap {
+  int rows = 0;
+  int cols = 0;
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+};
+
+class RangeImageGeometry {
+ public:
+  /**
+   * @brief Constructor to set the configuration.
+   *
+   * @param[in] config configuration of the geometry
+   */
+  RangeImageGeometry(const GeometryConfig& config);
+  /**
+   * @brief Find the points of the window around a pixel closer than radius to
+   * its point. The query pixel is not part of the result. This is an
+   * approximate search, points outside of the window are never found.
+   *
+   * @param[in] image image with the kX, kY, kZ and kRange channels
+   * @param[in] pixel index of the query pixel, e.g. from
+   * SphericalConversion::GetPointPixels
+   * @param[in] radius search radius (meters)
+   * @param[out] neighbors the neighbors, sorted by distance
+   * @return -1 A channel is missing or the pixel is out of the image or empty
+   * @return 1 search done successfully
+   */
+  int RadiusSearch(const SphericalImage& image, int32_t pixel, float radius,
+                   std::vector<Neighbor>* neighbors) const;
+  /**
+   * @brief Find the k points of the window around a pixel closest to its
+   * point, see RadiusSearch.
+   *
+   * @param[in] image image with the kX, kY, kZ and kRange channels
+   * @param[in] pixel index of the query pixel
+   * @param[in] k number of neighbors
+   * @param[out] neighbors at most k neighbors, sorted by distance
+   * @return -1 A channel is missing or the pixel is out of the image or empty
+   * @return 1 search done successfully
+   */
+  int KnnSearch(const SphericalImage& image, int32_t pixel, int k,
+                std::vector<Neighbor>* neighbors) const;
+  /**
+   * @brief Compute the normal of every pixel from the cross product of the
+   * horizontal and vertical differences between its neighbors. A neighbor
+   * that is empty or on another surface is replaced by the pixel itself.
+   *
+   * @param[in] image image with the kX, kY, kZ and kRange channels
+   * @param[out] normals the normal of every pixel
+   * @return -1 A channel is missing
+   * @return 1 normals computed successfully
+   */
+  int ComputeNormals(const SphericalImage& image, NormalMap* normals) const;
+  /**
+   * @brief Mark the ground pixels. Every column is walked up from the lowest
+   * beam, starting on the ground below the lidar, and a point is ground when
+   * the slope from the last ground point to it is below max_ground_slope.
+   *
+   * @param[in] image image with the kX, kY, kZ and kRange channels
+   * @param[out] ground 1 for the ground pixels, 0 otherwise, row major
+   * @return -1 A channel is missing
+   * @return 1 ground segmented successfully
+   */
+  int SegmentGround(const SphericalImage& image,
+                    std::vector<uint8_t>* ground) const;
+
+ private:
+  /**
+   * @brief Check that the image has the channels the geometry uses.
+   *
+   */
+  bool HasPoints(const SphericalImage& image) const;
+  /**
+   * @brief Collect the valid pixels of the window around a pixel with their
+   * squared distance to its point.
+   *
+   * @return -1 A channel is missing or the pixel is out of the image or empty
+   */
+  int SearchWindow(const SphericalImage& image, int32_t pixel,
+                   std::vector<Neighbor>* neighbors) const;
+  /**
+   * @brief The configuration of the geometry
+   *
+   */
+  const GeometryConfig config_;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_RANGE_IMAGE_GEOMETRY_H_
@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Multi channel image holding the result of the spherical projection.
+ * All the channels live in one contiguous float buffer, one plane per channel
+ * (channel, row, col order), so the image can be handed to a network without
+ * any conversion.
+ *
+ */
+#ifndef SPHERICAL_VIEW_PROJECTION_SPHERICAL_IMAGE_H_
+#define SPHERICAL_VIEW_PROJECTION_SPHERICAL_IMAGE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The values that can be stored for every pixel of the image. kCount is
+ * the number of points that fell in the pixel.
+ *
+ */
+enum class Channel : uint8_t { kX = 0, kY, kZ, kRange, kIntensity, kCount };
+
+/**
+ * @brief Number of values in the Channel enum.
+ *
+ */
+constexpr int kNumChannelTypes = 6;
+
+class SphericalImage {
+ public:
+  SphericalImage() { channel_index_.fill(-1); }
+  /**
+   * @brief Allocate an image with all the values set to 0.
+   *
+   * @param[in] rows number of rows (lasers) of the image
+   * @param[in] cols number of columns of the image
+   * @param[in] channels the channels to store, in the order of the planes
+   */
+  SphericalImage(const int rows, const int cols,
+                 const std::vector<Channel>& channels)
+      : rows_(rows), cols_(cols), channels_(channels) {
+    channel_index_.fill(-1);
+    for (size_t i = 0; i < channels_.size(); ++i) {
+      channel_index_[static_cast<int>(channels_[i])] = static_cast<int>(i);
+    }
+    data_.assign(static_cast<size_t>(rows_) * cols_ * channels_.size(), 0.0f);
+  }
+
+  int Rows() const { return rows_; }
+  int Cols() const { return cols_; }
+  int NumChannels() const { return static_cast<int>(channels_.size()); }
+  /**
+   * @brief Number of pixels in one plane.
+   *
+   */
+  size_t PlaneSize() const { return static_cast<size_t>(rows_) * cols_; }
+  const std::vector<Channel>& Channels() const { return channels_; }
+  /**
+   * @brief Index of the plane holding a channel.
+   *
+   * @param[in] channel
+   * @return -1 The channel is not stored in this image
+   */
+  int ChannelIndex(const Channel channel) const {
+    return channel_index_[static_cast<int>(channel)];
+  }
+  bool HasChannel(const Channel channel) const {
+    return ChannelIndex(channel) >= 0;
+  }
+  /**
+   * @brief Pointer to the first value of a plane, nullptr when the channel is
+   * not stored in this image.
+   *
+   */
+  float* Plane(const Channel channel) {
+    const int index = ChannelIndex(channel);
+    return index < 0 ? nullptr : Plane(index);
+  }
+  const float* Plane(const Channel channel) const {
+    const int index = ChannelIndex(channel);
+    return index < 0 ? nullptr : Plane(index);
+  }
+  float* Plane(const int channel_index) {
+    return data_.data() + channel_index * PlaneSize();
+  }
+  const float* Plane(const int channel_index) const {
+    return data_.data() + channel_index * PlaneSize();
+  }
+  /**
+   * @brief Value of a pixel in a plane. There is no bounds checking.
+   *
+   */
+  float& At(const int channel_index, const int row, const int col) {
+    return data_[channel_index * PlaneSize() +
+                 static_cast<size_t>(row) * cols_ + col];
+  }
+  const float& At(const int channel_index, const int row,
+                  const int col) const {
+    return data_[channel_index * PlaneSize() +
+                 static_cast<size_t>(row) * cols_ + col];
+  }
+  /**
+   * @brief The whole buffer, planes one after the other.
+   *
+   */
+  float* Data() { return data_.data(); }
+  const float* Data() const { return data_.data(); }
+  size_t Size() const { return data_.size(); }
+  void Fill(const float value) { std::fill(data_.begin(), data_.end(), value); }
+
+ private:
+  int rows_ = 0;
+  int cols_ = 0;
+  std::vector<Channel> channels_;
+  /**
+   * @brief Plane index of every Channel, -1 when it is not stored.
+   *
+   */
+  std::array<int, kNumChannelTypes> channel_index_;
+  std::vector<float> data_;
+};
+
+#endif  // SPHERICAL_VIEW_PROJECTION_SPHERICAL_IMAGE_H_
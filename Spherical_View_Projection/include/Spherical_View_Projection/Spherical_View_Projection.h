@@ -16,8 +16,45 @@
 #include <pcl/point_cloud.h>  // For PCL Point Cloud
 #include <pcl/point_types.h>  // For PCL different csloud types
 
+#include <Eigen/Geometry>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "Spherical_View_Projection/Bev_Image.h"
+#include "Spherical_View_Projection/Mapped_Scan.h"
+#include "Spherical_View_Projection/Parallel.h"
+#include "Spherical_View_Projection/Point_View.h"
+#include "Spherical_View_Projection/Spherical_Image.h"
+
+/**
+ * @brief How the value of a pixel is chosen when several points fall in it.
+ *
+ */
+enum class PixelPolicy : uint8_t {
+  /**
+   * @brief The point with the highest index in the cloud is kept.
+   *
+   */
+  kLast,
+  /**
+   * @brief The point with the smallest range is kept (z-buffer).
+   *
+   */
+  kNearest,
+  /**
+   * @brief The point with the largest range is kept.
+   *
+   */
+  kFarthest,
+  /**
+   * @brief Every channel holds the mean over the points of the pixel.
+   *
+   */
+  kMean,
+};
+
 /**
  * @brief this wraps all the configurations needed for doing spherical
  * projection.
@@ -45,6 +82,122 @@ struct Configuration {
    *
    */
   double img_length = 0.0;
+  /**
+   * @brief The number of threads used to make the image, started once with
+   * the SphericalConversion. 0 uses all the hardware threads.
+   *
+   */
+  int num_threads = 0;
+  /**
+   * @brief The channels stored in the projection image, in the order of its
+   * planes.
+   *
+   */
+  std::vector<Channel> channels{Channel::kX, Channel::kY, Channel::kZ,
+                                Channel::kRange, Channel::kIntensity};
+  /**
+   * @brief How the value of a pixel is chosen when several points fall in it.
+   * Ties are broken by the lowest point index.
+   *
+   */
+  PixelPolicy policy = PixelPolicy::kLast;
+  /**
+   * @brief Elevation of every laser of the lidar (degrees), indexed by ring,
+   * e.g. from the HDL-64E calibration file. When given it must hold
+   * num_lasers values and each point goes to the row of the beam with the
+   * closest elevation, the highest beam being row 0. When empty, the rows
+   * evenly split [fov_down, fov_up].
+   *
+   */
+  std::vector<double> laser_elevations;
+  /**
+   * @brief Bird's eye view made along with the projection image, in the same
+   * pass over the cloud, when bev.enabled is set.
+   *
+   */
+  BevConfig bev;
+};
+
+/**
+ * @brief Motion of the lidar during a sweep, used to de-skew the points. The
+ * pose at any time of the sweep is interpolated between the start and end
+ * poses, and every point is moved to the lidar frame at start_time.
+ *
+ */
+struct SweepMotion {
+  /**
+   * @brief Time of the start and end poses, with the same unit and origin as
+   * the timestamps of the points, e.g. seconds from the start of the sweep.
+   *
+   */
+  double start_time = 0.0;
+  double end_time = 0.1;
+  /**
+   * @brief Pose of the lidar at start_time and end_time in any fixed frame,
+   * e.g. from odometry.
+   *
+   */
+  Eigen::Isometry3d start_pose = Eigen::Isometry3d::Identity();
+  Eigen::Isometry3d end_pose = Eigen::Isometry3d::Identity();
+
+  /**
+   * @brief Motion of a lidar moving at constant velocity.
+   *
+   * @param[in] linear linear velocity in the lidar frame (m/s)
+   * @param[in] angular angular velocity in the lidar frame (rad/s)
+   * @param[in] start_time time of the first point of the sweep
+   * @param[in] end_time time of the last point of the sweep
+   * @return SweepMotion
+   */
+  static SweepMotion FromVelocity(const Eigen::Vector3d& linear,
+                                  const Eigen::Vector3d& angular,
+                                  const double start_time,
+                                  const double end_time) {
+    SweepMotion motion;
+    motion.start_time = start_time;
+    motion.end_time = end_time;
+    const double duration = end_time - start_time;
+    const double angle = angular.norm() * duration;
+    if (angle > 0.0) {
+      motion.end_pose.linear() =
+          Eigen::AngleAxisd(angle, angular.normalized()).toRotationMatrix();
+    }
+    motion.end_pose.translation() = linear * duration;
+    return motion;
+  }
+};
+
+/**
+ * @brief Points reconstructed from a projection image, one array per value
+ * (structure of arrays) so that they can be projected again with View.
+ *
+ */
+struct UnprojectedCloud {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  /**
+   * @brief Intensity of every point, 0 when the image has no intensity
+   * channel.
+   *
+   */
+  std::vector<float> intensity;
+  /**
+   * @brief Pixel index (row * img_length + col) every point comes from.
+   *
+   */
+  std::vector<int32_t> pixel;
+  /**
+   * @brief Label of every point, only filled when pixel labels are given.
+   *
+   */
+  std::vector<int32_t> label;
+
+  size_t size() const { return x.size(); }
+  PointView View() const {
+    return PointView::FromArrays(x.data(), y.data(), z.data(),
+                                 intensity.data(), x.size());
+  }
 };
 
 class SphericalConversion {
@@ -60,21 +213,185 @@ class SphericalConversion {
    * @brief Loads the point cloud of type .pcd in the cloud_ class variable.
    *
    * @param[in] path Absolute path to the .pcd file
-   * @return -1 The path is invalid
+   * @return -1 The path is invalid, the points loaded before are kept
    * @return 1 Cloud Loaded Successfully
    */
   int LoadCloud(const std::string& path);
+  /**
+   * @brief Memory map a scan of raw float32 x, y, z, intensity points (KITTI
+   * .bin). MakeImage then projects straight from the mapped file, until the
+   * next load.
+   *
+   * @param[in] path Absolute path to the .bin file
+   * @return -1 The file cannot be mapped, the points loaded before are kept
+   * @return 1 Scan mapped successfully
+   */
+  int LoadBin(const std::string& path);
   /**
    * @brief Function to iterate over each point of cloud and make the projection
    * image.
    *
+   * The cloud is split across config.num_threads threads and the angles are
+   * computed with the vectorized approximations in Fast_Math.h. When several
+   * points fall in the same pixel, config.policy decides the value of the
+   * pixel. The result is the same for any number of threads. Pixels that
+   * receive no point, and points that are not finite, are set to 0.
+   *
    * @return -1 The cloud is empty
    * @return 1 spherical image formed successfully
    */
   int MakeImage();
+  /**
+   * @brief Make the projection image using the ring index of every point for
+   * the rows instead of its elevation. Rings are mapped to rows through
+   * config.laser_elevations, or taken as 0 for the lowest beam when there is
+   * no table. Points with a ring of num_lasers or more are dropped.
+   *
+   * @param[in] rings ring index of every point of the cloud
+   * @return -1 The cloud is empty or rings does not match its size
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const std::vector<uint16_t>& rings);
+  /**
+   * @brief Make the projection image of the loaded cloud de-skewed with the
+   * motion of the lidar. Every point is moved to the lidar frame at the start
+   * of the sweep before being projected, the x, y, z channels hold the moved
+   * points.
+   *
+   * @param[in] timestamps time of every point of the cloud, see SweepMotion
+   * @param[in] motion motion of the lidar during the sweep
+   * @return -1 The cloud is empty, timestamps does not match its size or the
+   * motion ends before it starts
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const std::vector<float>& timestamps,
+                const SweepMotion& motion);
+  /**
+   * @brief Same as MakeImage(timestamps, motion) for points owned by the
+   * caller into a caller owned image.
+   *
+   * @param[in] points the points to project
+   * @param[in] timestamps time of every point
+   * @param[in] motion motion of the lidar during the sweep
+   * @param[out] image image made by CreateImage
+   * @param[out] bev bird's eye view made by CreateBev, nullptr to not make it
+   * @return -1 There is no point, an image does not match the configuration
+   * or the motion ends before it starts
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const PointView& points, const float* timestamps,
+                const SweepMotion& motion, SphericalImage* image,
+                BevImage* bev = nullptr);
+  /**
+   * @brief Make the projection image of points owned by the caller, e.g.
+   * separate x, y, z, intensity arrays with PointView::FromArrays. No PCL
+   * type is involved.
+   *
+   * @param[in] points the points to project
+   * @return -1 There is no point
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const PointView& points);
+  /**
+   * @brief Same as MakeImage(points) into a caller owned image. Calls on the
+   * same object must not run concurrently.
+   *
+   * @param[in] points the points to project
+   * @param[out] image image made by CreateImage
+   * @param[out] bev bird's eye view made by CreateBev, nullptr to not make it
+   * @return -1 There is no point or an image does not match the
+   * configuration
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const PointView& points, SphericalImage* image,
+                BevImage* bev = nullptr);
+  /**
+   * @brief Make the projection image of a cloud other than the loaded one
+   * into a caller owned image, e.g. a reusable buffer of a pipeline. Calls on
+   * the same object must not run concurrently.
+   *
+   * @param[in] cloud the cloud to project
+   * @param[out] image image made by CreateImage
+   * @param[out] bev bird's eye view made by CreateBev, nullptr to not make it
+   * @return -1 The cloud is empty or an image does not match the
+   * configuration
+   * @return 1 spherical image formed successfully
+   */
+  int MakeImage(const pcl::PointCloud<pcl::PointXYZI>& cloud,
+                SphericalImage* image, BevImage* bev = nullptr);
+  /**
+   * @brief Reconstruct a point from every pixel with a positive range, the
+   * inverse of MakeImage. The point is placed at the range of the pixel along
+   * the direction of the center of the pixel, or of the beam of its row with
+   * config.laser_elevations, so it is off the original point by at most half
+   * a pixel of angle. The points are in pixel order.
+   *
+   * @param[in] image image with a kRange channel matching the configuration
+   * @param[out] cloud the reconstructed points
+   * @return -1 The image has no range channel or does not match the
+   * configuration
+   * @return 1 cloud reconstructed successfully
+   */
+  int Unproject(const SphericalImage& image, UnprojectedCloud* cloud) const;
+  /**
+   * @brief Same as Unproject(image, cloud), also giving every point the label
+   * of its pixel, e.g. the output of a segmentation network.
+   *
+   * @param[in] image image with a kRange channel matching the configuration
+   * @param[in] pixel_labels label of every pixel, row major
+   * @param[out] cloud the reconstructed points and their labels
+   * @return -1 The image has no range channel, the image or the labels do not
+   * match the configuration
+   * @return 1 cloud reconstructed successfully
+   */
+  int Unproject(const SphericalImage& image,
+                const std::vector<int32_t>& pixel_labels,
+                UnprojectedCloud* cloud) const;
+  /**
+   * @brief Give every point of the last projected cloud the label of its
+   * pixel. All the points of a pixel share its label, not only the one kept
+   * in the image.
+   *
+   * @param[in] pixel_labels label of every pixel, row major
+   * @param[out] point_labels label of every point of the cloud
+   * @param[in] unlabeled label of the points dropped by the projection
+   * @return -1 Nothing was projected yet or the labels do not match the
+   * configuration
+   * @return 1 labels gathered successfully
+   */
+  int GatherPixelLabels(const std::vector<int32_t>& pixel_labels,
+                        std::vector<int32_t>* point_labels,
+                        int32_t unlabeled = -1) const;
+  /**
+   * @brief Pixel index (row * img_length + col) of every point of the last
+   * projected cloud, -1 for the dropped points.
+   *
+   * @return const std::vector<int32_t>& valid until the next MakeImage
+   */
+  const std::vector<int32_t>& GetPointPixels() const;
+  /**
+   * @brief Index of the point kept in every pixel by the last MakeImage, -1
+   * when the pixel is empty.
+   *
+   * @return const std::vector<int32_t>& valid until the next MakeImage
+   */
+  const std::vector<int32_t>& GetPixelPoints() const;
+  /**
+   * @brief Allocate an empty image matching the configuration.
+   *
+   * @return SphericalImage
+   */
+  SphericalImage CreateImage() const;
+  /**
+   * @brief Allocate an empty bird's eye view matching the configuration.
+   *
+   * @return BevImage empty when the bird's eye view is disabled
+   */
+  BevImage CreateBev() const;
   /**
    * @brief Convert 3D point to 2D pixel cooredinated by doing Spherical
-   * Projection
+   * Projection. This is the exact, one point at a time version of the
+   * projection done by MakeImage when the rows are evenly spaced.
    *
    * @param[in] point
    * @param[in] fov_rad
@@ -90,33 +407,296 @@ class SphericalConversion {
   /**
    * @brief function to return the spherical image
    *
-   * @return auto
+   * @return const SphericalImage& the image, valid until the next MakeImage
+   */
+  const SphericalImage& GetImg() const;
+  /**
+   * @brief function to return the bird's eye view, made by the MakeImage
+   * overloads without a caller owned image when config.bev.enabled is set.
+   *
+   * @return const BevImage& the grid, empty when the bird's eye view is
+   * disabled, valid until the next MakeImage
    */
-  auto GetImg() const;
+  const BevImage& GetBev() const;
   /**
-   * @brief Use OpenCv to view the spherical image formed
+   * @brief Use OpenCv to view the intensity channel of the spherical image
+   * formed. Uses no state of a conversion.
    *
    * @param img
+   * @param wait_ms time to wait for a key, 0 waits forever
    */
-  void ShowImg(const std::vector<std::vector<std::vector<double>>>& img) const;
+  static void ShowImg(const SphericalImage& img, int wait_ms = 0);
 
  private:
+  /**
+   * @brief Precompute the projection constants and the row tables from the
+   * configuration.
+   *
+   */
+  void BuildTables();
+  /**
+   * @brief Precompute the direction of the center of every row and column for
+   * Unproject.
+   *
+   */
+  void BuildDirectionTables();
+  /**
+   * @brief Precompute the transforms de-skewing the points along the sweep.
+   *
+   * @param[in] motion motion of the lidar during the sweep
+   * @return -1 The motion ends before it starts
+   */
+  int SetMotion(const SweepMotion& motion);
+  /**
+   * @brief Make the projection image, see MakeImage.
+   *
+   * @param[in] points the points to project
+   * @param[in] rings ring index of every point, nullptr to use the elevation
+   * @param[in] timestamps time of every point to de-skew them with the motion
+   * given to SetMotion, nullptr to project them as they are
+   * @param[out] image the projection image
+   * @param[out] bev the bird's eye view, nullptr to not make it
+   */
+  int Project(const PointView& points, const uint16_t* rings,
+              const float* timestamps, SphericalImage* image, BevImage* bev);
+  /**
+   * @brief Compute the pixel index (row * img_length + col) and range of the
+   * points [begin, end) of the cloud into point_pixel_ and point_range_, -1
+   * for the dropped points.
+   *
+   * The points are copied in small blocks to contiguous x, y, z arrays so that
+   * the math runs on several points per instruction. With timestamps, the
+   * points are de-skewed in the block and stored in deskewed_.
+   *
+   * @param[in] points the points to project
+   * @param[in] begin index of the first point
+   * @param[in] end index after the last point
+   * @param[in] rings ring index of every point, nullptr to use the elevation
+   * @param[in] timestamps time of every point, nullptr to not de-skew
+   * @param[in] with_bev whether to add the points to the bird's eye view
+   */
+  void ProjectPoints(const PointView& points, size_t begin, size_t end,
+                     const uint16_t* rings, const float* timestamps,
+                     bool with_bev);
+  /**
+   * @brief Key with which a point claims its pixel, the smallest key wins.
+   * The high 32 bits hold the priority given by config_.policy and the low 32
+   * bits the point index.
+   *
+   * @param[in] point index of the point
+   * @return uint64_t the key
+   */
+  uint64_t PointKey(size_t point) const;
+  /**
+   * @brief Claim the pixels of the points [begin, end) without locks, and add
+   * them to the counts and sums when those are needed.
+   *
+   * @param[in] points the points to project
+   * @param[in] begin index of the first point
+   * @param[in] end index after the last point
+   */
+  void ClaimPixels(const PointView& points, size_t begin, size_t end);
+  /**
+   * @brief Write the points of [begin, end) that own their pixel to every
+   * plane of the image.
+   *
+   * @param[in] points the points to project
+   * @param[in] begin index of the first point
+   * @param[in] end index after the last point
+   * @param[out] image the projection image
+   */
+  void WritePoints(const PointView& points, size_t begin, size_t end,
+                   SphericalImage* image) const;
+  /**
+   * @brief Zero the empty pixels of [begin, end), write the count and mean
+   * channels, record the point kept in each pixel in pixel_point_ and reset
+   * the owners, counts and sums for the next call.
+   *
+   * @param[in] begin index of the first pixel
+   * @param[in] end index after the last pixel
+   * @param[out] image the projection image
+   */
+  void FinishPixels(size_t begin, size_t end, SphericalImage* image);
+  /**
+   * @brief Add a block of points to the cells of the bird's eye view without
+   * locks, while they are in the local arrays of ProjectPoints.
+   *
+   * @param[in] x x of the points
+   * @param[in] y y of the points
+   * @param[in] z z of the points
+   * @param[in] first index of the first point of the block in the cloud
+   * @param[in] count number of points in the block, at most 64
+   */
+  void AccumulateBev(const float* x, const float* y, const float* z,
+                     size_t first, size_t count);
+  /**
+   * @brief Write the cells [begin, end) of the bird's eye view and reset them
+   * for the next call.
+   *
+   * @param[in] points the projected points, for the intensities
+   * @param[in] begin index of the first cell
+   * @param[in] end index after the last cell
+   * @param[out] bev the bird's eye view
+   */
+  void FinishBev(const PointView& points, size_t begin, size_t end,
+                 BevImage* bev);
+  /**
+   * @brief Reconstruct the points of an image, see Unproject.
+   *
+   * @param[in] image image with a kRange channel
+   * @param[in] pixel_labels label of every pixel, nullptr when there is none
+   * @param[out] cloud the reconstructed points
+   */
+  int UnprojectPixels(const SphericalImage& image,
+                      const int32_t* pixel_labels,
+                      UnprojectedCloud* cloud) const;
   /**
    * @brief The configuration required for forming the spherical projection
    *
    */
   const Configuration config_;
+  /**
+   * @brief config_.num_threads threads running every loop of the object, so
+   * that MakeImage does not start threads. Mutable since the const methods
+   * run their loops on it too.
+   *
+   */
+  mutable ThreadPool pool_;
+  /**
+   * @brief col = yaw * col_scale_ + col_offset_, same for the rows with the
+   * pitch when the rows are evenly spaced.
+   *
+   */
+  double col_scale_ = 0.0;
+  double col_offset_ = 0.0;
+  double row_scale_ = 0.0;
+  double row_offset_ = 0.0;
+  /**
+   * @brief Row of every ring index.
+   *
+   */
+  std::vector<int32_t> ring_row_;
+  /**
+   * @brief Tangent of the elevations separating consecutive rows, in
+   * decreasing order and padded with -inf to a power of two. Empty when the
+   * rows are evenly spaced.
+   *
+   */
+  std::vector<float> row_boundaries_;
+  /**
+   * @brief Transform (3x4 row major) moving a point to the lidar frame at the
+   * start of the sweep at evenly spaced times of the sweep, see SetMotion.
+   *
+   */
+  std::vector<float> knots_;
+  /**
+   * @brief Position in the sweep, from 0 to 1, of a point with timestamp t is
+   * t * time_scale_ + time_offset_.
+   *
+   */
+  float time_scale_ = 0.0f;
+  float time_offset_ = 0.0f;
+  /**
+   * @brief The de-skewed points, x, y, z and intensity planes of the size of
+   * the cloud.
+   *
+   */
+  std::vector<float> deskewed_;
+  /**
+   * @brief Sine and cosine of the elevation of every row and of the yaw of
+   * every column, at their center.
+   *
+   */
+  std::vector<float> row_sin_;
+  std::vector<float> row_cos_;
+  std::vector<float> col_sin_;
+  std::vector<float> col_cos_;
   /**
    * @brief this will hold the projected image
    *
    */
-  std::vector<std::vector<std::vector<double>>> spherical_img_;
+  SphericalImage spherical_img_;
   /**
    * @brief the point cloud will be loaded and accesible to the class through
    * this variable.
    *
    */
   pcl::PointCloud<pcl::PointXYZI>::Ptr cloud_;
+  /**
+   * @brief Scan mapped by LoadBin.
+   *
+   */
+  MappedScan scan_;
+  /**
+   * @brief The points projected by MakeImage, either cloud_ or scan_.
+   *
+   */
+  PointView source_;
+  /**
+   * @brief Pixel index of every point of the cloud, filled by MakeImage.
+   *
+   */
+  std::vector<int32_t> point_pixel_;
+  /**
+   * @brief Range of every point of the cloud, filled by MakeImage.
+   *
+   */
+  std::vector<float> point_range_;
+  /**
+   * @brief Number of values summed per pixel for PixelPolicy::kMean, the
+   * channels kX to kIntensity.
+   *
+   */
+  static constexpr int kNumSummedValues = 5;
+  /**
+   * @brief Key (see PointKey) of the point that owns each pixel, all bits set
+   * when the pixel is empty. Points claim pixels with an atomic min so that
+   * threads need no lock.
+   *
+   */
+  std::unique_ptr<std::atomic<uint64_t>[]> pixel_owner_;
+  /**
+   * @brief Number of points in each pixel, only allocated for the kCount
+   * channel and PixelPolicy::kMean.
+   *
+   */
+  std::unique_ptr<std::atomic<uint32_t>[]> pixel_count_;
+  /**
+   * @brief Fixed point sums of the summed values of each pixel, one plane per
+   * value, only allocated for PixelPolicy::kMean.
+   *
+   */
+  std::unique_ptr<std::atomic<int64_t>[]> pixel_sum_;
+  /**
+   * @brief Index of the point kept in every pixel, -1 when the pixel is
+   * empty, filled by MakeImage.
+   *
+   */
+  std::vector<int32_t> pixel_point_;
+  /**
+   * @brief The bird's eye view, see Configuration::bev.
+   *
+   */
+  BevImage bev_img_;
+  /**
+   * @brief Key of the highest point of every cell, its height above the
+   * bottom of the grid in the high 32 bits and UINT32_MAX minus its index in
+   * the low 32 bits, 0 when the cell is empty. Points update it with an
+   * atomic max, only allocated with the bird's eye view.
+   *
+   */
+  std::unique_ptr<std::atomic<uint64_t>[]> bev_top_;
+  /**
+   * @brief Number of points in every cell.
+   *
+   */
+  std::unique_ptr<std::atomic<uint32_t>[]> bev_count_;
+  /**
+   * @brief Bits of the height of the highest point of every cell in each
+   * slice, above the bottom of the slice, one plane per slice.
+   *
+   */
+  std::unique_ptr<std::atomic<uint32_t>[]> bev_height_;
 };
 
 #endif  // SPHERICAL_VIEW_PROJECTION_SPHERICAL_VIEW_PROJECTION_H_
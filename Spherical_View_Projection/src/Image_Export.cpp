@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Write projection images to disk without a display, as 16 bit PNG
+ * images or raw float32 planes.
+ *
+ */
+
+#include "Spherical_View_Projection/Image_Export.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <opencv2/opencv.hpp>  // For writing the PNG images
+
+ImageExporter::ImageExporter(const ExportConfig& config) : config_(config) {}
+
+int ImageExporter::Export(const SphericalImage& image,
+                          const std::string& prefix) {
+    if (config_.format == ExportFormat::kRaw) {
+        return WriteRaw(image, prefix + ".bin");
+    }
+    if (image.HasChannel(Channel::kRange) &&
+        WritePng16(image, Channel::kRange, config_.range_scale,
+                   prefix + "_range.png") == -1) {
+        return -1;
+    }
+    if (image.HasChannel(Channel::kIntensity) &&
+        WritePng16(image, Channel::kIntensity, config_.intensity_scale,
+                   prefix + "_intensity.png") == -1) {
+        return -1;
+    }
+    return 1;
+}
+
+void ImageExporter::ToUInt16(const float* values, const size_t size,
+                             const float scale, uint16_t* converted) {
+    for (size_t i = 0; i < size; ++i) {
+        // Clamping before the conversion makes truncation act as rounding.
+        float value = values[i] * scale + 0.5f;
+        value = std::max(0.0f, std::min(65535.0f, value));
+        converted[i] = static_cast<uint16_t>(static_cast<int32_t>(value));
+    }
+}
+
+int ImageExporter::WritePng16(const SphericalImage& image,
+                              const Channel channel, const float scale,
+                              const std::string& path) {
+    converted_.resize(image.PlaneSize());
+    ToUInt16(image.Plane(channel), image.PlaneSize(), scale,
+             converted_.data());
+    // Wraps the converted plane, no copy is made.
+    const cv::Mat png(image.Rows(), image.Cols(), CV_16UC1,
+                      converted_.data());
+    if (!cv::imwrite(path, png)) {
+        std::cout << "Couldn't write the image at: " << path << "\n";
+        return -1;
+    }
+    return 1;
+}
+
+int ImageExporter::WriteRaw(const SphericalImage& image,
+                            const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(image.Data()),
+               image.Size() * sizeof(float));
+    if (!file) {
+        std::cout << "Couldn't write the image at: " << path << "\n";
+        return -1;
+    }
+    return 1;
+}
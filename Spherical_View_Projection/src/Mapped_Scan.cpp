@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Memory mapped lidar scan stored as raw float32 x, y, z, intensity
+ * values, as in the KITTI velodyne .bin files. The points are read straight
+ * from the page cache, nothing is parsed or copied.
+ *
+ */
+
+#include "Spherical_View_Projection/Mapped_Scan.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+/**
+ * @brief Number of floats per point in the file.
+ *
+ */
+constexpr size_t kFloatsPerPoint = 4;
+}  // namespace
+
+MappedScan::~MappedScan() { Close(); }
+
+int MappedScan::Open(const std::string& path) {
+    // The previous scan stays mapped until the new one is, so that a file
+    // which cannot be mapped leaves it in place.
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file == -1) {
+        std::cout << "Couldn't read the scan file at: " << path << "\n";
+        return -1;
+    }
+    struct stat file_stat;
+    if (fstat(file, &file_stat) == -1 ||
+        file_stat.st_size % (kFloatsPerPoint * sizeof(float)) != 0) {
+        std::cout << "Not a float32 x, y, z, intensity scan: " << path << "\n";
+        close(file);
+        return -1;
+    }
+    const size_t num_bytes = static_cast<size_t>(file_stat.st_size);
+    void* data = nullptr;
+    if (num_bytes > 0) {
+        data = mmap(nullptr, num_bytes, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    // The mapping stays valid once the file is closed.
+    close(file);
+    if (data == MAP_FAILED) {
+        std::cout << "Couldn't map the scan file at: " << path << "\n";
+        return -1;
+    }
+    Close();
+    data_ = data;
+    num_bytes_ = num_bytes;
+    num_points_ = num_bytes_ / (kFloatsPerPoint * sizeof(float));
+    // The whole scan is about to be read, start reading it ahead.
+    if (data_) {
+        madvise(data_, num_bytes_, MADV_WILLNEED);
+    }
+    return 1;
+}
+
+void MappedScan::Close() {
+    if (data_) {
+        munmap(data_, num_bytes_);
+    }
+    data_ = nullptr;
+    num_bytes_ = 0;
+    num_points_ = 0;
+}
+
+PointView MappedScan::View() const {
+    return PointView::FromInterleaved(static_cast<const float*>(data_),
+                                      num_points_, kFloatsPerPoint);
+}
+
+int WriteSyntheticScan(const std::string& path, const double fov_up,
+                       const double fov_down, const int num_lasers,
+                       const int num_columns) {
+    constexpr double kSensorHeight = 1.73;
+    constexpr double kMaxRange = 80.0;
+    std::vector<float> points;
+    points.reserve(kFloatsPerPoint * num_lasers * num_columns);
+    for (int laser = 0; laser < num_lasers; ++laser) {
+        const double pitch =
+            (fov_up - (laser + 0.5) * (fov_up - fov_down) / num_lasers) *
+            M_PI / 180.0;
+        for (int column = 0; column < num_columns; ++column) {
+            const double yaw = M_PI - (column + 0.5) * 2.0 * M_PI / num_columns;
+            // The beam stops at the ground or at the wall, whichever is
+            // closer.
+            const double wall = (15.0 + 5.0 * std::sin(3.0 * yaw)) /
+                                std::max(std::cos(pitch), 1e-3);
+            const double ground = pitch < 0.0 ? kSensorHeight / -std::sin(pitch)
+                                              : kMaxRange;
+            const double range = std::min({wall, ground, kMaxRange});
+            points.push_back(range * std::cos(pitch) * std::cos(yaw));
+            points.push_back(range * std::cos(pitch) * std::sin(yaw));
+            points.push_back(range * std::sin(pitch));
+            points.push_back(ground < wall ? 0.2f : 0.6f);
+        }
+    }
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(points.data()),
+               points.size() * sizeof(float));
+    if (!file) {
+        std::cout << "Couldn't write the scan file at: " << path << "\n";
+        return -1;
+    }
+    return 1;
+}
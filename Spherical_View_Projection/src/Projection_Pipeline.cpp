@@ -0,0 +1,176 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Pipeline to project a stream of point clouds. Loading frame N + 1,
+ * projecting frame N and consuming frame N - 1 run at the same time on their
+ * own threads, and the clouds and images are reused from frame to frame.
+ *
+ */
+
+#include "Spherical_View_Projection/Projection_Pipeline.h"
+
+#include <pcl/io/pcd_io.h>  // For Reading the Cloud
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "Spherical_View_Projection/Pipeline_Utils.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Queue passing frames between two stages. Pop blocks until a value is
+ * available or the queue is closed.
+ *
+ */
+template <typename T>
+class BlockingQueue {
+   public:
+    void Push(const T& value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push(value);
+        }
+        condition_.notify_one();
+    }
+    /**
+     * @brief Take the oldest value.
+     *
+     * @param[out] value
+     * @return false The queue is closed and empty
+     */
+    bool Pop(T* value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+        if (queue_.empty()) {
+            return false;
+        }
+        *value = queue_.front();
+        queue_.pop();
+        return true;
+    }
+    /**
+     * @brief No value will be pushed anymore.
+     *
+     */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        condition_.notify_all();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::queue<T> queue_;
+    bool closed_ = false;
+};
+}  // namespace
+
+ProjectionPipeline::ProjectionPipeline(const Configuration& config,
+                                       const int num_buffers)
+    : conv_(config), frames_(std::max(3, num_buffers)) {
+    for (auto& frame : frames_) {
+        frame.image = conv_.CreateImage();
+        frame.bev = conv_.CreateBev();
+    }
+}
+
+PipelineStats ProjectionPipeline::Run(const std::vector<std::string>& paths,
+                                      const Consumer& consume) {
+    BlockingQueue<Frame*> free_frames;
+    BlockingQueue<Frame*> loaded_frames;
+    BlockingQueue<Frame*> projected_frames;
+    for (auto& frame : frames_) {
+        free_frames.Push(&frame);
+    }
+    // Every counter is only touched by its own stage until the threads are
+    // joined.
+    size_t num_loaded = 0;
+    size_t num_projected = 0;
+    double load_seconds = 0.0;
+    double project_seconds = 0.0;
+    double consume_seconds = 0.0;
+    PipelineStats stats;
+    const auto run_start = Clock::now();
+
+    std::thread loader([&]() {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            Frame* frame = nullptr;
+            free_frames.Pop(&frame);
+            const auto start = Clock::now();
+            frame->is_scan = IsBinFile(paths[i]);
+            int status = -1;
+            if (frame->is_scan) {
+                status = frame->scan.Open(paths[i]);
+            } else {
+                status = pcl::io::loadPCDFile<pcl::PointXYZI>(paths[i],
+                                                              frame->cloud);
+                if (status == -1) {
+                    std::cout << "Couldn't read the cloud file at: "
+                              << paths[i] << "\n";
+                }
+            }
+            load_seconds += SecondsSince(start);
+            if (status == -1) {
+                free_frames.Push(frame);
+                continue;
+            }
+            ++num_loaded;
+            frame->index = i;
+            loaded_frames.Push(frame);
+        }
+        loaded_frames.Close();
+    });
+    std::thread projector([&]() {
+        Frame* frame = nullptr;
+        while (loaded_frames.Pop(&frame)) {
+            const auto start = Clock::now();
+            const int status =
+                frame->is_scan ? conv_.MakeImage(frame->scan.View(),
+                                                 &frame->image, &frame->bev)
+                               : conv_.MakeImage(frame->cloud, &frame->image,
+                                                 &frame->bev);
+            project_seconds += SecondsSince(start);
+            if (status == -1) {
+                free_frames.Push(frame);
+                continue;
+            }
+            ++num_projected;
+            projected_frames.Push(frame);
+        }
+        projected_frames.Close();
+    });
+
+    Frame* frame = nullptr;
+    while (projected_frames.Pop(&frame)) {
+        const auto start = Clock::now();
+        consume(frame->index, frame->image, frame->bev);
+        consume_seconds += SecondsSince(start);
+        ++stats.frames;
+        free_frames.Push(frame);
+    }
+    loader.join();
+    projector.join();
+
+    const double run_seconds = SecondsSince(run_start);
+    stats.fps = run_seconds > 0.0 ? stats.frames / run_seconds : 0.0;
+    stats.load_ms = num_loaded ? 1e3 * load_seconds / num_loaded : 0.0;
+    stats.project_ms =
+        num_projected ? 1e3 * project_seconds / num_projected : 0.0;
+    stats.consume_ms =
+        stats.frames ? 1e3 * consume_seconds / stats.frames : 0.0;
+    return stats;
+}
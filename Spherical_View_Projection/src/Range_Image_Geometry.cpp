@@ -0,0 +1,324 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Geometry computed directly on the spherical projection image. The
+ * neighbors of a point are the points of the pixels around its own, so
+ * neighbor search, surface normals and ground segmentation need no k-d tree.
+ *
+ */
+
+#include "Spherical_View_Projection/Range_Image_Geometry.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "Spherical_View_Projection/Parallel.h"
+
+namespace {
+bool CloserNeighbor(const Neighbor& a, const Neighbor& b) {
+    return a.distance_sq < b.distance_sq ||
+           (a.distance_sq == b.distance_sq && a.pixel < b.pixel);
+}
+}  // namespace
+
+RangeImageGeometry::RangeImageGeometry(const GeometryConfig& config)
+    : config_(config) {}
+
+bool RangeImageGeometry::HasPoints(const SphericalImage& image) const {
+    if (!image.HasChannel(Channel::kX) || !image.HasChannel(Channel::kY) ||
+        !image.HasChannel(Channel::kZ) || !image.HasChannel(Channel::kRange)) {
+        std::cerr << "The image needs the x, y, z and range channels"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int RangeImageGeometry::SearchWindow(const SphericalImage& image,
+                                     const int32_t pixel,
+                                     std::vector<Neighbor>* neighbors) const {
+    if (!HasPoints(image)) {
+        return -1;
+    }
+    if (pixel < 0 || static_cast<size_t>(pixel) >= image.PlaneSize()) {
+        std::cerr << "The pixel " << pixel << " is out of the image"
+                  << std::endl;
+        return -1;
+    }
+    const float* x = image.Plane(Channel::kX);
+    const float* y = image.Plane(Channel::kY);
+    const float* z = image.Plane(Channel::kZ);
+    const float* range = image.Plane(Channel::kRange);
+    if (!(range[pixel] > 0.0f)) {
+        std::cerr << "The pixel " << pixel << " is empty" << std::endl;
+        return -1;
+    }
+    const int rows = image.Rows();
+    const int cols = image.Cols();
+    const int row = pixel / cols;
+    const int col = pixel % cols;
+    // A narrow image would otherwise visit the same column twice.
+    const int half_cols = std::min(config_.half_window_cols, (cols - 1) / 2);
+    const int first_row = std::max(0, row - config_.half_window_rows);
+    const int last_row = std::min(rows - 1, row + config_.half_window_rows);
+
+    neighbors->clear();
+    for (int r = first_row; r <= last_row; ++r) {
+        for (int offset = -half_cols; offset <= half_cols; ++offset) {
+            int c = col + offset;
+            c += c < 0 ? cols : 0;
+            c -= c >= cols ? cols : 0;
+            const int32_t neighbor = r * cols + c;
+            if (neighbor == pixel || !(range[neighbor] > 0.0f)) {
+                continue;
+            }
+            const float dx = x[neighbor] - x[pixel];
+            const float dy = y[neighbor] - y[pixel];
+            const float dz = z[neighbor] - z[pixel];
+            neighbors->push_back({neighbor, dx * dx + dy * dy + dz * dz});
+        }
+    }
+    return 1;
+}
+
+int RangeImageGeometry::RadiusSearch(const SphericalImage& image,
+                                     const int32_t pixel, const float radius,
+                                     std::vector<Neighbor>* neighbors) const {
+    if (SearchWindow(image, pixel, neighbors) == -1) {
+        return -1;
+    }
+    const float radius_sq = radius * radius;
+    neighbors->erase(std::remove_if(neighbors->begin(), neighbors->end(),
+                                    [radius_sq](const Neighbor& neighbor) {
+                                        return neighbor.distance_sq >
+                                               radius_sq;
+                                    }),
+                     neighbors->end());
+    std::sort(neighbors->begin(), neighbors->end(), CloserNeighbor);
+    return 1;
+}
+
+int RangeImageGeometry::KnnSearch(const SphericalImage& image,
+                                  const int32_t pixel, const int k,
+                                  std::vector<Neighbor>* neighbors) const {
+    if (SearchWindow(image, pixel, neighbors) == -1) {
+        return -1;
+    }
+    const size_t count =
+        std::min(neighbors->size(), static_cast<size_t>(std::max(0, k)));
+    std::partial_sort(neighbors->begin(), neighbors->begin() + count,
+                      neighbors->end(), CloserNeighbor);
+    neighbors->resize(count);
+    return 1;
+}
+
+int RangeImageGeometry::ComputeNormals(const SphericalImage& image,
+                                       NormalMap* normals) const {
+    if (!HasPoints(image)) {
+        return -1;
+    }
+    const float* x = image.Plane(Channel::kX);
+    const float* y = image.Plane(Channel::kY);
+    const float* z = image.Plane(Channel::kZ);
+    const float* range = image.Plane(Channel::kRange);
+    const size_t rows = image.Rows();
+    const size_t cols = image.Cols();
+    const size_t num_pixels = image.PlaneSize();
+    const float max_jump = config_.max_range_jump;
+    normals->rows = image.Rows();
+    normals->cols = image.Cols();
+    normals->x.resize(num_pixels);
+    normals->y.resize(num_pixels);
+    normals->z.resize(num_pixels);
+    float* normal_x = normals->x.data();
+    float* normal_y = normals->y.data();
+    float* normal_z = normals->z.data();
+
+    ParallelFor(num_pixels, config_.num_threads, [&](const size_t begin,
+                                                     const size_t end) {
+        constexpr size_t kBlockSize = 64;
+        // The row is copied with the last column before the first one and the
+        // first column after the last one, so the columns wrap around without
+        // a branch.
+        const size_t padded_cols = cols + 2;
+        std::vector<float> padded(4 * padded_cols);
+        float* row_x = padded.data();
+        float* row_y = row_x + padded_cols;
+        float* row_z = row_y + padded_cols;
+        float* row_range = row_z + padded_cols;
+        // The normals of a block are written to local arrays first, which the
+        // compiler knows alias nothing, so the loop runs on several pixels per
+        // instruction.
+        float block_x[kBlockSize];
+        float block_y[kBlockSize];
+        float block_z[kBlockSize];
+        for (size_t start = begin; start < end;) {
+            const size_t row = start / cols;
+            const size_t first_col = start - row * cols;
+            const size_t count = std::min(end - start, cols - first_col);
+            const float* planes[4] = {x, y, z, range};
+            float* padded_planes[4] = {row_x, row_y, row_z, row_range};
+            for (int plane = 0; plane < 4; ++plane) {
+                const float* source = planes[plane] + row * cols;
+                float* target = padded_planes[plane];
+                std::copy(source, source + cols, target + 1);
+                target[0] = source[cols - 1];
+                target[cols + 1] = source[0];
+            }
+            // Row 0 is the highest beam, the first and last rows use the
+            // pixel itself for the missing side.
+            const size_t up = (row > 0 ? row - 1 : row) * cols;
+            const size_t down = (row + 1 < rows ? row + 1 : row) * cols;
+            const float* up_x = x + up;
+            const float* up_y = y + up;
+            const float* up_z = z + up;
+            const float* up_range = range + up;
+            const float* down_x = x + down;
+            const float* down_y = y + down;
+            const float* down_z = z + down;
+            const float* down_range = range + down;
+            for (size_t block = 0; block < count; block += kBlockSize) {
+                const size_t block_size = std::min(kBlockSize, count - block);
+                const size_t block_col = first_col + block;
+                for (size_t i = 0; i < block_size; ++i) {
+                    const size_t col = block_col + i;
+                    const float cx = row_x[col + 1];
+                    const float cy = row_y[col + 1];
+                    const float cz = row_z[col + 1];
+                    const float cr = row_range[col + 1];
+                    const float jump = max_jump * cr;
+                    // Neighbors that are empty or on another surface are
+                    // replaced by the pixel itself. & instead of && keeps the
+                    // loop free of branches.
+                    const bool left_ok =
+                        (row_range[col] > 0.0f) &
+                        (std::abs(row_range[col] - cr) <= jump);
+                    const bool right_ok =
+                        (row_range[col + 2] > 0.0f) &
+                        (std::abs(row_range[col + 2] - cr) <= jump);
+                    const bool up_ok = (up_range[col] > 0.0f) &
+                                       (std::abs(up_range[col] - cr) <= jump);
+                    const bool down_ok =
+                        (down_range[col] > 0.0f) &
+                        (std::abs(down_range[col] - cr) <= jump);
+                    // Every neighbor is loaded before choosing, a load under
+                    // a condition would keep the loop from being vectorized.
+                    const float left_x = row_x[col];
+                    const float left_y = row_y[col];
+                    const float left_z = row_z[col];
+                    const float right_x = row_x[col + 2];
+                    const float right_y = row_y[col + 2];
+                    const float right_z = row_z[col + 2];
+                    const float above_x = up_x[col];
+                    const float above_y = up_y[col];
+                    const float above_z = up_z[col];
+                    const float below_x = down_x[col];
+                    const float below_y = down_y[col];
+                    const float below_z = down_z[col];
+                    const float hx =
+                        (right_ok ? right_x : cx) - (left_ok ? left_x : cx);
+                    const float hy =
+                        (right_ok ? right_y : cy) - (left_ok ? left_y : cy);
+                    const float hz =
+                        (right_ok ? right_z : cz) - (left_ok ? left_z : cz);
+                    const float vx =
+                        (up_ok ? above_x : cx) - (down_ok ? below_x : cx);
+                    const float vy =
+                        (up_ok ? above_y : cy) - (down_ok ? below_y : cy);
+                    const float vz =
+                        (up_ok ? above_z : cz) - (down_ok ? below_z : cz);
+                    const float nx = hy * vz - hz * vy;
+                    const float ny = hz * vx - hx * vz;
+                    const float nz = hx * vy - hy * vx;
+                    const float length_sq = nx * nx + ny * ny + nz * nz;
+                    const bool valid = (cr > 0.0f) & (length_sq > 0.0f);
+                    // Point the normal towards the lidar.
+                    const float sign =
+                        nx * cx + ny * cy + nz * cz > 0.0f ? -1.0f : 1.0f;
+                    const float scale =
+                        valid ? sign / std::sqrt(valid ? length_sq : 1.0f)
+                              : 0.0f;
+                    block_x[i] = nx * scale;
+                    block_y[i] = ny * scale;
+                    block_z[i] = nz * scale;
+                }
+                const size_t pixel = row * cols + block_col;
+                std::copy(block_x, block_x + block_size, normal_x + pixel);
+                std::copy(block_y, block_y + block_size, normal_y + pixel);
+                std::copy(block_z, block_z + block_size, normal_z + pixel);
+            }
+            start += count;
+        }
+    });
+    return 1;
+}
+
+int RangeImageGeometry::SegmentGround(const SphericalImage& image,
+                                      std::vector<uint8_t>* ground) const {
+    if (!HasPoints(image)) {
+        return -1;
+    }
+    const float* x = image.Plane(Channel::kX);
+    const float* y = image.Plane(Channel::kY);
+    const float* z = image.Plane(Channel::kZ);
+    const float* range = image.Plane(Channel::kRange);
+    const int rows = image.Rows();
+    const size_t cols = image.Cols();
+    const float max_slope = std::tan(config_.max_ground_slope / 180 * M_PI);
+    const float max_slope_sq = max_slope * max_slope;
+    const float start_z = -config_.sensor_height;
+    ground->resize(image.PlaneSize());
+    uint8_t* is_ground = ground->data();
+
+    // The columns are independent. They are walked up in blocks, every row
+    // being one step of all the columns of the block at once, with the state
+    // in local arrays so that the loop runs on several columns per
+    // instruction. A column is a step for every row, so a thread takes
+    // about as many steps as with the loops over pixels.
+    const size_t min_columns = std::max<size_t>(1, 4096 / std::max(rows, 1));
+    ParallelFor(cols, config_.num_threads, [&](const size_t begin,
+                                               const size_t end) {
+        constexpr size_t kBlockSize = 64;
+        float last_x[kBlockSize];
+        float last_y[kBlockSize];
+        float last_z[kBlockSize];
+        uint8_t block_ground[kBlockSize];
+        for (size_t block = begin; block < end; block += kBlockSize) {
+            const size_t block_size = std::min(kBlockSize, end - block);
+            // Last ground point of every column, the ground below the lidar
+            // at first.
+            std::fill(last_x, last_x + kBlockSize, 0.0f);
+            std::fill(last_y, last_y + kBlockSize, 0.0f);
+            std::fill(last_z, last_z + kBlockSize, start_z);
+            for (int row = rows - 1; row >= 0; --row) {
+                const size_t offset = row * cols + block;
+                const float* row_x = x + offset;
+                const float* row_y = y + offset;
+                const float* row_z = z + offset;
+                const float* row_range = range + offset;
+                for (size_t i = 0; i < block_size; ++i) {
+                    const float dx = row_x[i] - last_x[i];
+                    const float dy = row_y[i] - last_y[i];
+                    const float dz = row_z[i] - last_z[i];
+                    const bool on_ground =
+                        (row_range[i] > 0.0f) &
+                        (dz * dz <= max_slope_sq * (dx * dx + dy * dy));
+                    last_x[i] = on_ground ? row_x[i] : last_x[i];
+                    last_y[i] = on_ground ? row_y[i] : last_y[i];
+                    last_z[i] = on_ground ? row_z[i] : last_z[i];
+                    block_ground[i] = on_ground;
+                }
+                std::copy(block_ground, block_ground + block_size,
+                          is_ground + offset);
+            }
+        }
+    }, min_columns);
+    return 1;
+}
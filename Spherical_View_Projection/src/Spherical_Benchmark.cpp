@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Benchmark of the loading, projection and export of a point cloud,
+ * reporting the time per frame and the points per second of every stage.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "Spherical_View_Projection/Image_Export.h"
+#include "Spherical_View_Projection/Pipeline_Utils.h"
+#include "Spherical_View_Projection/Spherical_View_Projection.h"
+
+#ifndef SPHERICAL_ASSETS_DIR
+#define SPHERICAL_ASSETS_DIR "assests"
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+void PrintStage(const std::string& name, const double seconds,
+                const int iterations, const size_t num_points) {
+    const double frame_seconds = seconds / iterations;
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << 1e3 * frame_seconds << " ms/frame" << std::setw(12)
+              << num_points / frame_seconds / 1e6 << " Mpoints/s\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && (std::string(argv[1]) == "-h" ||
+                     std::string(argv[1]) == "--help")) {
+        std::cout << "Usage: " << argv[0]
+                  << " [file.pcd | file.bin] [iterations] [output prefix]\n"
+                  << "Defaults to " SPHERICAL_ASSETS_DIR "/test_cloud.pcd, "
+                  << "or a synthetic scan when it is missing, 20 iterations "
+                  << "and /tmp/spherical_benchmark\n";
+        return 0;
+    }
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    const std::string output = argc > 3 ? argv[3] : "/tmp/spherical_benchmark";
+
+    const Configuration config{2, -24.8, 64, 1024};
+    const std::string path =
+        argc > 1 ? argv[1]
+                 : DefaultCloudPath(SPHERICAL_ASSETS_DIR "/test_cloud.pcd",
+                                    output + "_synthetic.bin", config);
+    if (path.empty()) {
+        return 1;
+    }
+    SphericalConversion conv(config);
+    const bool is_scan = IsBinFile(path);
+    auto load = [&]() {
+        return is_scan ? conv.LoadBin(path) : conv.LoadCloud(path);
+    };
+    ExportConfig png_config;
+    ExportConfig raw_config;
+    raw_config.format = ExportFormat::kRaw;
+    ImageExporter png(png_config);
+    ImageExporter raw(raw_config);
+    // One untimed run allocates the buffers and checks that every stage
+    // works.
+    if (load() == -1 || conv.MakeImage() == -1 ||
+        png.Export(conv.GetImg(), output) == -1 ||
+        raw.Export(conv.GetImg(), output) == -1) {
+        return 1;
+    }
+    const size_t num_points = conv.GetPointPixels().size();
+    // A file that cannot be loaded keeps the points loaded before.
+    const std::string missing = output + "_missing";
+    const int missing_load =
+        is_scan ? conv.LoadBin(missing) : conv.LoadCloud(missing);
+    if (missing_load != -1 || conv.MakeImage() == -1 ||
+        conv.GetPointPixels().size() != num_points) {
+        std::cerr << "A failed load did not keep the loaded points\n";
+        return 1;
+    }
+
+    double load_seconds = 0.0;
+    double project_seconds = 0.0;
+    double png_seconds = 0.0;
+    double raw_seconds = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        load();
+        load_seconds += SecondsSince(start);
+        start = Clock::now();
+        conv.MakeImage();
+        project_seconds += SecondsSince(start);
+        start = Clock::now();
+        png.Export(conv.GetImg(), output);
+        png_seconds += SecondsSince(start);
+        start = Clock::now();
+        raw.Export(conv.GetImg(), output);
+        raw_seconds += SecondsSince(start);
+    }
+    std::cout << path << ": " << num_points << " points, " << iterations
+              << " iterations\n";
+    PrintStage(is_scan ? "LoadBin" : "LoadCloud", load_seconds, iterations,
+               num_points);
+    PrintStage("MakeImage", project_seconds, iterations, num_points);
+    PrintStage("Export png", png_seconds, iterations, num_points);
+    PrintStage("Export raw", raw_seconds, iterations, num_points);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ * Copyright (c) 2020 Anirudh Topiwala
+ * Author: Anirudh Topiwala
+ * Create Date: 2020-03
+ * Last Edit Date: 2020-03
+ *
+ * @brief Node projecting the point clouds given on the command line, either
+ * showing the images or writing them to disk.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Spherical_View_Projection/Image_Export.h"
+#include "Spherical_View_Projection/Pipeline_Utils.h"
+#include "Spherical_View_Projection/Projection_Pipeline.h"
+#include "Spherical_View_Projection/Spherical_View_Projection.h"
+
+#ifndef SPHERICAL_ASSETS_DIR
+#define SPHERICAL_ASSETS_DIR "assests"
+#endif
+
+namespace {
+void PrintUsage(const char* name) {
+    std::cout
+        << "Usage: " << name << " [options] [file.pcd | file.bin]...\n"
+        << "Projects the clouds, " SPHERICAL_ASSETS_DIR "/test_cloud.pcd "
+        << "or a synthetic scan when none is given, and shows the intensity "
+        << "images.\n"
+        << "  --output PREFIX   write the images to PREFIX_<frame> instead "
+        << "of showing them\n"
+        << "  --format FORMAT   png16 (16 bit range and intensity PNG, "
+        << "default) or raw (float32 planes)\n"
+        << "  --fov-up DEG      upper field of view (default 2)\n"
+        << "  --fov-down DEG    lower field of view (default -24.8)\n"
+        << "  --lasers N        number of lasers, the image rows (default 64)\n"
+        << "  --width N         number of image columns (default 1024)\n"
+        << "  --threads N       projection threads, 0 for all (default 0)\n";
+}
+
+/**
+ * @brief Parse a whole string as a number.
+ *
+ * @return false The string is not a number
+ */
+bool ParseNumber(const std::string& text, double* value) {
+    char* end = nullptr;
+    *value = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    /** For Velodyne HDL 64-E
+     * Fov_Up = 2 degrees
+     * Fov_Down = -24.8 degrees
+     * Num of Lasers = 64
+     * Best length of image comes out to be = 1024
+     */
+    Configuration config{2, -24.8, 64, 1024};
+    ExportConfig export_config;
+    std::string output;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "-h" || option == "--help") {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        if (option.compare(0, 2, "--") != 0) {
+            paths.push_back(option);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing the value of " << option << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        const std::string value = argv[++i];
+        double number = 0.0;
+        const bool is_number = ParseNumber(value, &number);
+        if (option == "--output") {
+            output = value;
+        } else if (option == "--format" && value == "png16") {
+            export_config.format = ExportFormat::kPng16;
+        } else if (option == "--format" && value == "raw") {
+            export_config.format = ExportFormat::kRaw;
+        } else if (option == "--fov-up" && is_number) {
+            config.fov_up = number;
+        } else if (option == "--fov-down" && is_number) {
+            config.fov_down = number;
+        } else if (option == "--lasers" && is_number && number >= 1) {
+            config.num_lasers = static_cast<int>(number);
+        } else if (option == "--width" && is_number && number >= 1) {
+            config.img_length = static_cast<int>(number);
+        } else if (option == "--threads" && is_number && number >= 0) {
+            config.num_threads = static_cast<int>(number);
+        } else {
+            std::cerr << "Invalid option " << option << " " << value
+                      << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (paths.empty()) {
+        const std::string path =
+            DefaultCloudPath(SPHERICAL_ASSETS_DIR "/test_cloud.pcd",
+                             "/tmp/spherical_node_synthetic.bin", config);
+        if (path.empty()) {
+            return 1;
+        }
+        paths.push_back(path);
+    }
+
+    ProjectionPipeline pipeline(config);
+    PipelineStats stats;
+    size_t num_failed = 0;
+    if (output.empty()) {
+        // A single image stays on screen until a key is pressed.
+        const int wait_ms = paths.size() == 1 ? 0 : 1;
+        stats = pipeline.Run(paths, [wait_ms](const size_t,
+                                              const SphericalImage& image,
+                                              const BevImage&) {
+            SphericalConversion::ShowImg(image, wait_ms);
+        });
+    } else {
+        ImageExporter exporter(export_config);
+        stats = pipeline.Run(paths, [&](const size_t frame,
+                                        const SphericalImage& image,
+                                        const BevImage&) {
+            char suffix[32];
+            std::snprintf(suffix, sizeof(suffix), "_%06zu", frame);
+            if (exporter.Export(image, output + suffix) == -1) {
+                ++num_failed;
+            }
+        });
+    }
+    std::cout << stats.frames << " frames at " << stats.fps
+              << " fps. Per frame: load " << stats.load_ms << " ms, project "
+              << stats.project_ms << " ms, consume " << stats.consume_ms
+              << " ms" << std::endl;
+    return stats.frames == paths.size() && num_failed == 0 ? 0 : 1;
+}
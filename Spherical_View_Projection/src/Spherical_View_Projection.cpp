@@ -18,48 +18,748 @@
 #include <pcl/point_cloud.h>  // For PCL Point Cloud
 #include <pcl/point_types.h>  // For PCL different cloud types
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <iostream>
+#include <limits>
 #include <opencv2/opencv.hpp>  // For visualizing image
 #include <vector>
 
+#include "Spherical_View_Projection/Fast_Math.h"
+#include "Spherical_View_Projection/Parallel.h"
+
+namespace {
+/**
+ * @brief Owner key of a pixel that received no point.
+ *
+ */
+constexpr uint64_t kEmptyPixel = std::numeric_limits<uint64_t>::max();
+/**
+ * @brief Values are summed in fixed point for PixelPolicy::kMean, integer
+ * addition being associative makes the mean independent of the order in which
+ * the threads add their points. 2^20 gives a resolution of 1e-6 m and leaves
+ * room for a million points of 1000 m in an int64_t.
+ *
+ */
+constexpr double kFixedPointScale = 1 << 20;
+/**
+ * @brief Number of intervals between the de-skewing transforms of a sweep.
+ * The transform of a point is interpolated between the two closest ones, with
+ * an error in the order of the square of the rotation between them.
+ *
+ */
+constexpr int kNumKnots = 64;
+/**
+ * @brief Number of floats of a 3x4 transform.
+ *
+ */
+constexpr int kKnotSize = 12;
+/**
+ * @brief Number of points ProjectPoints copies to its local arrays at once.
+ *
+ */
+constexpr size_t kBlockSize = 64;
+
+/**
+ * @brief Bits of a float. For non negative values, the order of the bits is
+ * the order of the values.
+ *
+ */
+uint32_t FloatBits(const float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsToFloat(const uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Lock free maximum, target becomes max(target, value).
+ *
+ */
+template <typename T>
+void AtomicMax(std::atomic<T>& target, const T value) {
+    T current = target.load(std::memory_order_relaxed);
+    while (current < value &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed)) {
+    }
+}
+
+int64_t ToFixedPoint(const float value) {
+    return static_cast<int64_t>(std::llround(value * kFixedPointScale));
+}
+
+bool SameShape(const SphericalImage& a, const SphericalImage& b) {
+    return a.Rows() == b.Rows() && a.Cols() == b.Cols() &&
+           a.Channels() == b.Channels();
+}
+
+bool SameShape(const BevImage& a, const BevImage& b) {
+    return a.Rows() == b.Rows() && a.Cols() == b.Cols() &&
+           a.NumSlices() == b.NumSlices();
+}
+
+/**
+ * @brief View of the points of a PCL cloud, read in place.
+ *
+ */
+PointView CloudView(const pcl::PointCloud<pcl::PointXYZI>& cloud) {
+    if (cloud.empty()) {
+        return PointView{};
+    }
+    const pcl::PointXYZI& first = cloud.points.front();
+    PointView view = PointView::FromInterleaved(
+        &first.x, cloud.size(), sizeof(pcl::PointXYZI) / sizeof(float));
+    view.intensity = &first.intensity;
+    return view;
+}
+}  // namespace
+
 SphericalConversion::SphericalConversion(const Configuration& config)
-    : config_(config) {
-    spherical_img_.assign(config_.num_lasers,
-                          std::vector<std::vector<double>>(
-                              config_.img_length, std::vector<double>(5, 0.0)));
+    : config_(config),
+      pool_(config_.num_threads),
+      spherical_img_(static_cast<int>(config_.num_lasers),
+                     static_cast<int>(config_.img_length), config_.channels) {
     cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(
         new pcl::PointCloud<pcl::PointXYZI>);
+    source_ = CloudView(*cloud_);
+    BuildTables();
+    BuildDirectionTables();
+    const size_t num_pixels = spherical_img_.PlaneSize();
+    pixel_point_.assign(num_pixels, -1);
+    pixel_owner_.reset(new std::atomic<uint64_t>[num_pixels]);
+    for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+        pixel_owner_[pixel].store(kEmptyPixel, std::memory_order_relaxed);
+    }
+    if (config_.policy == PixelPolicy::kMean ||
+        spherical_img_.HasChannel(Channel::kCount)) {
+        pixel_count_.reset(new std::atomic<uint32_t>[num_pixels]);
+        for (size_t pixel = 0; pixel < num_pixels; ++pixel) {
+            pixel_count_[pixel].store(0, std::memory_order_relaxed);
+        }
+    }
+    if (config_.policy == PixelPolicy::kMean) {
+        const size_t num_sums = kNumSummedValues * num_pixels;
+        pixel_sum_.reset(new std::atomic<int64_t>[num_sums]);
+        for (size_t i = 0; i < num_sums; ++i) {
+            pixel_sum_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    const BevConfig& bev = config_.bev;
+    if (!bev.enabled) {
+        return;
+    }
+    const bool increasing_slices =
+        bev.height_slices.size() >= 2 &&
+        std::is_sorted(bev.height_slices.begin(), bev.height_slices.end(),
+                       std::less_equal<float>());
+    if (!(bev.cell_size > 0.0f) || !(bev.x_max > bev.x_min) ||
+        !(bev.y_max > bev.y_min) || !increasing_slices) {
+        std::cerr << "Invalid bird's eye view configuration, it is disabled"
+                  << std::endl;
+        return;
+    }
+    const int num_slices = static_cast<int>(bev.height_slices.size()) - 1;
+    bev_img_ = BevImage(
+        static_cast<int>(std::ceil((bev.x_max - bev.x_min) / bev.cell_size)),
+        static_cast<int>(std::ceil((bev.y_max - bev.y_min) / bev.cell_size)),
+        num_slices);
+    const size_t num_cells = bev_img_.PlaneSize();
+    bev_top_.reset(new std::atomic<uint64_t>[num_cells]);
+    bev_count_.reset(new std::atomic<uint32_t>[num_cells]);
+    bev_height_.reset(new std::atomic<uint32_t>[num_slices * num_cells]);
+    for (size_t cell = 0; cell < num_cells; ++cell) {
+        bev_top_[cell].store(0, std::memory_order_relaxed);
+        bev_count_[cell].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < num_slices * num_cells; ++i) {
+        bev_height_[i].store(0, std::memory_order_relaxed);
+    }
 };
 
+void SphericalConversion::BuildTables() {
+    // Converting to Radians
+    const double fov_up_rad = std::abs(config_.fov_up / 180 * M_PI);
+    const double fov_down_rad = std::abs(config_.fov_down / 180 * M_PI);
+    // Getting total Field of View
+    const double fov_rad = fov_up_rad + fov_down_rad;
+    const int num_rows = static_cast<int>(config_.num_lasers);
+    // Image coordinates are a linear function of the angles, fold the
+    // normalization and scaling of GetProjection into one multiply add.
+    col_scale_ = 0.5 * config_.img_length / M_PI;
+    col_offset_ = 0.5 * config_.img_length;
+    row_scale_ = -config_.num_lasers / fov_rad;
+    row_offset_ = config_.num_lasers * (1.0 - fov_down_rad / fov_rad);
+
+    // Without a table, ring 0 is taken as the lowest beam as in the Velodyne
+    // drivers.
+    ring_row_.resize(num_rows);
+    for (int ring = 0; ring < num_rows; ++ring) {
+        ring_row_[ring] = num_rows - 1 - ring;
+    }
+    row_boundaries_.clear();
+    if (config_.laser_elevations.empty()) {
+        return;
+    }
+    if (static_cast<int>(config_.laser_elevations.size()) != num_rows) {
+        std::cerr << "Expected " << num_rows << " laser elevations, got "
+                  << config_.laser_elevations.size()
+                  << ". Using evenly spaced rows." << std::endl;
+        return;
+    }
+    // Row 0 is the highest beam.
+    std::vector<int> rings(num_rows);
+    for (int ring = 0; ring < num_rows; ++ring) {
+        rings[ring] = ring;
+    }
+    std::sort(rings.begin(), rings.end(), [this](const int a, const int b) {
+        return config_.laser_elevations[a] > config_.laser_elevations[b];
+    });
+    for (int row = 0; row < num_rows; ++row) {
+        ring_row_[rings[row]] = row;
+    }
+    // A point belongs to the beam with the closest elevation, so the rows are
+    // separated by the elevations halfway between consecutive beams. They are
+    // stored as tangents to compare with z / sqrt(x^2 + y^2) directly, and
+    // padded to a power of two for the binary search.
+    int table_size = 1;
+    while (table_size < num_rows) {
+        table_size *= 2;
+    }
+    row_boundaries_.assign(table_size,
+                           -std::numeric_limits<float>::infinity());
+    for (int row = 0; row + 1 < num_rows; ++row) {
+        const double middle = 0.5 * (config_.laser_elevations[rings[row]] +
+                                     config_.laser_elevations[rings[row + 1]]);
+        row_boundaries_[row] = std::tan(middle / 180 * M_PI);
+    }
+}
+
+void SphericalConversion::BuildDirectionTables() {
+    const int num_rows = spherical_img_.Rows();
+    const int num_cols = spherical_img_.Cols();
+    // Evenly spaced rows are centered between their boundaries, with a table
+    // every row points along its beam.
+    std::vector<double> row_pitch(num_rows);
+    for (int row = 0; row < num_rows; ++row) {
+        row_pitch[row] = (row + 0.5 - row_offset_) / row_scale_;
+    }
+    if (!row_boundaries_.empty()) {
+        for (size_t ring = 0; ring < ring_row_.size(); ++ring) {
+            row_pitch[ring_row_[ring]] =
+                config_.laser_elevations[ring] / 180 * M_PI;
+        }
+    }
+    row_sin_.resize(num_rows);
+    row_cos_.resize(num_rows);
+    for (int row = 0; row < num_rows; ++row) {
+        row_sin_[row] = std::sin(row_pitch[row]);
+        row_cos_[row] = std::cos(row_pitch[row]);
+    }
+    col_sin_.resize(num_cols);
+    col_cos_.resize(num_cols);
+    for (int col = 0; col < num_cols; ++col) {
+        const double yaw = (col + 0.5 - col_offset_) / col_scale_;
+        col_sin_[col] = std::sin(yaw);
+        col_cos_[col] = std::cos(yaw);
+    }
+}
+
 int SphericalConversion::LoadCloud(const std::string& path) {
-    // Loading from Bin File
-    if (pcl::io::loadPCDFile<pcl::PointXYZI>(path, *cloud_) == -1) {
+    // Loading from PCD File. The cloud is read aside so that a file which
+    // cannot be read leaves the loaded points in place.
+    pcl::PointCloud<pcl::PointXYZI>::Ptr cloud(
+        new pcl::PointCloud<pcl::PointXYZI>);
+    if (pcl::io::loadPCDFile<pcl::PointXYZI>(path, *cloud) == -1) {
         std::cout << "Couldn't read the cloud file at: " << path << "\n";
         return -1;
     }
+    cloud_ = cloud;
+    source_ = CloudView(*cloud_);
     return 1;
 }
+
+int SphericalConversion::LoadBin(const std::string& path) {
+    if (scan_.Open(path) == -1) {
+        return -1;
+    }
+    source_ = scan_.View();
+    return 1;
+}
+
 int SphericalConversion::MakeImage() {
-    // Converting to Radians
-    double fov_up_rad = (config_.fov_up / 180) * M_PI;
-    double fov_down_rad = (config_.fov_down / 180) * M_PI;
-    // Getting total Field of View
-    double fov_rad = std::abs(fov_up_rad) + std::abs(fov_down_rad);
-    if (cloud_->size() == 0) {
+    return Project(source_, nullptr, nullptr, &spherical_img_, &bev_img_);
+}
+
+int SphericalConversion::MakeImage(const std::vector<uint16_t>& rings) {
+    if (rings.size() != source_.size) {
+        std::cerr << "Got " << rings.size() << " ring indices for "
+                  << source_.size << " points" << std::endl;
+        return -1;
+    }
+    return Project(source_, rings.data(), nullptr, &spherical_img_, &bev_img_);
+}
+
+int SphericalConversion::MakeImage(const std::vector<float>& timestamps,
+                                   const SweepMotion& motion) {
+    if (timestamps.size() != source_.size) {
+        std::cerr << "Got " << timestamps.size() << " timestamps for "
+                  << source_.size << " points" << std::endl;
+        return -1;
+    }
+    if (SetMotion(motion) == -1) {
+        return -1;
+    }
+    return Project(source_, nullptr, timestamps.data(), &spherical_img_,
+                   &bev_img_);
+}
+
+int SphericalConversion::MakeImage(const PointView& points) {
+    return Project(points, nullptr, nullptr, &spherical_img_, &bev_img_);
+}
+
+int SphericalConversion::MakeImage(const PointView& points,
+                                   SphericalImage* image, BevImage* bev) {
+    if (!SameShape(*image, spherical_img_) ||
+        (bev && !SameShape(*bev, bev_img_))) {
+        std::cerr << "The image does not match the configuration" << std::endl;
+        return -1;
+    }
+    return Project(points, nullptr, nullptr, image, bev);
+}
+
+int SphericalConversion::MakeImage(const PointView& points,
+                                   const float* timestamps,
+                                   const SweepMotion& motion,
+                                   SphericalImage* image, BevImage* bev) {
+    if (!SameShape(*image, spherical_img_) ||
+        (bev && !SameShape(*bev, bev_img_))) {
+        std::cerr << "The image does not match the configuration" << std::endl;
+        return -1;
+    }
+    if (SetMotion(motion) == -1) {
+        return -1;
+    }
+    return Project(points, nullptr, timestamps, image, bev);
+}
+
+int SphericalConversion::MakeImage(
+    const pcl::PointCloud<pcl::PointXYZI>& cloud, SphericalImage* image,
+    BevImage* bev) {
+    return MakeImage(CloudView(cloud), image, bev);
+}
+
+SphericalImage SphericalConversion::CreateImage() const {
+    return SphericalImage(spherical_img_.Rows(), spherical_img_.Cols(),
+                          spherical_img_.Channels());
+}
+
+BevImage SphericalConversion::CreateBev() const {
+    return BevImage(bev_img_.Rows(), bev_img_.Cols(), bev_img_.NumSlices());
+}
+
+int SphericalConversion::SetMotion(const SweepMotion& motion) {
+    const double duration = motion.end_time - motion.start_time;
+    if (!(duration > 0.0)) {
+        std::cerr << "The sweep must end after it starts" << std::endl;
+        return -1;
+    }
+    time_scale_ = 1.0 / duration;
+    time_offset_ = -motion.start_time / duration;
+    const Eigen::Quaterniond start_rotation(motion.start_pose.rotation());
+    const Eigen::Quaterniond end_rotation(motion.end_pose.rotation());
+    const Eigen::Isometry3d to_start = motion.start_pose.inverse();
+    knots_.resize((kNumKnots + 1) * kKnotSize);
+    for (int knot = 0; knot <= kNumKnots; ++knot) {
+        const double s = static_cast<double>(knot) / kNumKnots;
+        Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+        pose.linear() =
+            start_rotation.slerp(s, end_rotation).toRotationMatrix();
+        pose.translation() = (1.0 - s) * motion.start_pose.translation() +
+                             s * motion.end_pose.translation();
+        const Eigen::Matrix4d transform = (to_start * pose).matrix();
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                knots_[knot * kKnotSize + row * 4 + col] = transform(row, col);
+            }
+        }
+    }
+    return 1;
+}
+
+int SphericalConversion::Project(const PointView& points,
+                                 const uint16_t* rings,
+                                 const float* timestamps,
+                                 SphericalImage* image, BevImage* bev) {
+    if (points.size == 0) {
         std::cerr << "Empty Point Cloud_" << std::endl;
         return -1;
     }
-    for (auto point : *cloud_) {
-        // Getting Pixel from Point
-        int pixel_v = 0;
-        int pixel_u = 0;
-        double range = 0.0;
-        GetProjection(point, fov_rad, fov_down_rad, &pixel_v, &pixel_u, &range);
-        spherical_img_.at(pixel_u).at(pixel_v) = std::vector<double>{
-            point.x, point.y, point.z, range, point.intensity};
+    const size_t num_points = points.size;
+    point_pixel_.resize(num_points);
+    point_range_.resize(num_points);
+    // De-skewed points are stored while they are projected, the later phases
+    // read them instead of the cloud.
+    PointView source = points;
+    if (timestamps) {
+        deskewed_.resize(4 * num_points);
+        const float* deskewed = deskewed_.data();
+        source = PointView::FromArrays(deskewed, deskewed + num_points,
+                                       deskewed + 2 * num_points,
+                                       deskewed + 3 * num_points, num_points);
+    }
+    // The bird's eye view is only made when it is enabled and wanted.
+    const bool with_bev = bev_top_ && bev;
+    // Project the points and claim their pixels. The pixel goes to the
+    // smallest key, so the result does not depend on how the threads
+    // interleave.
+    pool_.For(num_points, [this, &points, &source, rings, timestamps,
+                           with_bev](const size_t begin, const size_t end) {
+        ProjectPoints(points, begin, end, rings, timestamps, with_bev);
+        ClaimPixels(source, begin, end);
+    });
+    // Every point that won its pixel writes itself to the image. Walking the
+    // points in order keeps the reads of the cloud sequential. The mean is
+    // written from the sums when the pixels are finished.
+    if (config_.policy != PixelPolicy::kMean) {
+        pool_.For(num_points, [this, &source, image](const size_t begin,
+                                                     const size_t end) {
+            WritePoints(source, begin, end, image);
+        });
+    }
+    // Clear the pixels that received no point and release the pixels for the
+    // next call.
+    pool_.For(image->PlaneSize(),
+              [this, image](const size_t begin, const size_t end) {
+                  FinishPixels(begin, end, image);
+              });
+    if (with_bev) {
+        pool_.For(bev->PlaneSize(),
+                  [this, &source, bev](const size_t begin, const size_t end) {
+                      FinishBev(source, begin, end, bev);
+                  });
     }
     return 1;
 }
 
+void SphericalConversion::ProjectPoints(const PointView& points,
+                                        const size_t begin, const size_t end,
+                                        const uint16_t* rings,
+                                        const float* timestamps,
+                                        const bool with_bev) {
+    const float col_scale = col_scale_;
+    const float col_offset = col_offset_;
+    const float row_scale = row_scale_;
+    const float row_offset = row_offset_;
+    const float max_col = config_.img_length - 1.0f;
+    const float max_row = config_.num_lasers - 1.0f;
+    const int32_t cols = static_cast<int32_t>(config_.img_length);
+    const int32_t num_rings = static_cast<int32_t>(ring_row_.size());
+    const int32_t* ring_row = ring_row_.data();
+    const float* boundaries = row_boundaries_.data();
+    const int table_size = static_cast<int>(row_boundaries_.size());
+    const float time_scale = time_scale_;
+    const float time_offset = time_offset_;
+    const float* knots = knots_.data();
+    const size_t num_points = points.size;
+
+    float x[kBlockSize];
+    float y[kBlockSize];
+    float z[kBlockSize];
+    int32_t row[kBlockSize];
+    for (size_t block = begin; block < end; block += kBlockSize) {
+        const size_t block_size = std::min(kBlockSize, end - block);
+        for (size_t i = 0; i < block_size; ++i) {
+            x[i] = points.X(block + i);
+            y[i] = points.Y(block + i);
+            z[i] = points.Z(block + i);
+        }
+        if (timestamps) {
+            // Move every point to the lidar frame at the start of the sweep,
+            // with the transform interpolated between the two knots around
+            // its timestamp.
+            for (size_t i = 0; i < block_size; ++i) {
+                float knot_time =
+                    timestamps[block + i] * time_scale + time_offset;
+                knot_time = std::max(0.0f, std::min(1.0f, knot_time)) *
+                            static_cast<float>(kNumKnots);
+                const int32_t knot =
+                    std::min(static_cast<int32_t>(knot_time), kNumKnots - 1);
+                const float weight = knot_time - knot;
+                const float* before = knots + knot * kKnotSize;
+                const float* after = before + kKnotSize;
+                float m[kKnotSize];
+                for (int j = 0; j < kKnotSize; ++j) {
+                    m[j] = before[j] + weight * (after[j] - before[j]);
+                }
+                const float px = x[i];
+                const float py = y[i];
+                const float pz = z[i];
+                x[i] = m[0] * px + m[1] * py + m[2] * pz + m[3];
+                y[i] = m[4] * px + m[5] * py + m[6] * pz + m[7];
+                z[i] = m[8] * px + m[9] * py + m[10] * pz + m[11];
+            }
+            float* deskewed = deskewed_.data() + block;
+            for (size_t i = 0; i < block_size; ++i) {
+                deskewed[i] = x[i];
+                deskewed[num_points + i] = y[i];
+                deskewed[2 * num_points + i] = z[i];
+                deskewed[3 * num_points + i] = points.Intensity(block + i);
+            }
+        }
+        if (with_bev) {
+            AccumulateBev(x, y, z, block, block_size);
+        }
+        if (rings) {
+            // Rows straight from the ring index, out of range rings are
+            // dropped.
+            for (size_t i = 0; i < block_size; ++i) {
+                const int32_t ring = rings[block + i];
+                row[i] = ring < num_rings ? ring_row[ring] : -1;
+            }
+        } else if (table_size > 0) {
+            // Branch free binary search of the beam in the elevation table,
+            // counting the boundaries above the point.
+            for (size_t i = 0; i < block_size; ++i) {
+                const float planar = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+                const float slope = z[i] / (planar > 0.0f ? planar : 1e-20f);
+                int32_t position = 0;
+                for (int step = table_size / 2; step > 0; step /= 2) {
+                    position +=
+                        boundaries[position + step - 1] > slope ? step : 0;
+                }
+                row[i] = position;
+            }
+        } else {
+            for (size_t i = 0; i < block_size; ++i) {
+                const float r =
+                    std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+                const float pitch = FastAsin(z[i] / (r > 0.0f ? r : 1.0f));
+                // Clamping before the conversion makes truncation act as
+                // floor.
+                float u = pitch * row_scale + row_offset;
+                u = std::max(0.0f, std::min(max_row, u));
+                row[i] = static_cast<int32_t>(u);
+            }
+        }
+        int32_t* pixel = point_pixel_.data() + block;
+        float* range = point_range_.data() + block;
+        for (size_t i = 0; i < block_size; ++i) {
+            const float r = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+            const float yaw = FastAtan2(y[i], x[i]);
+            float v = yaw * col_scale + col_offset;
+            v = std::max(0.0f, std::min(max_col, v));
+            // NaN and infinite points (e.g. from organized clouds) are dropped.
+            const bool valid =
+                r <= std::numeric_limits<float>::max() && row[i] >= 0;
+            pixel[i] = valid ? row[i] * cols + static_cast<int32_t>(v) : -1;
+            range[i] = r;
+        }
+    }
+}
+
+uint64_t SphericalConversion::PointKey(const size_t point) const {
+    uint32_t priority = 0;
+    switch (config_.policy) {
+        case PixelPolicy::kLast:
+            priority = std::numeric_limits<uint32_t>::max() -
+                       static_cast<uint32_t>(point);
+            break;
+        case PixelPolicy::kNearest:
+        case PixelPolicy::kMean:
+            priority = FloatBits(point_range_[point]);
+            break;
+        case PixelPolicy::kFarthest:
+            priority = ~FloatBits(point_range_[point]);
+            break;
+    }
+    return (static_cast<uint64_t>(priority) << 32) | point;
+}
+
+void SphericalConversion::ClaimPixels(const PointView& points,
+                                      const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const int32_t pixel = point_pixel_[i];
+        if (pixel < 0) {
+            continue;
+        }
+        // Atomic min of the packed (priority, index) key, the index makes the
+        // keys unique so ties are broken the same way on every run.
+        const uint64_t key = PointKey(i);
+        auto& owner = pixel_owner_[pixel];
+        uint64_t current = owner.load(std::memory_order_relaxed);
+        while (key < current &&
+               !owner.compare_exchange_weak(current, key,
+                                            std::memory_order_relaxed)) {
+        }
+        if (pixel_count_) {
+            pixel_count_[pixel].fetch_add(1, std::memory_order_relaxed);
+        }
+        if (pixel_sum_) {
+            const float values[kNumSummedValues] = {
+                points.X(i), points.Y(i), points.Z(i), point_range_[i],
+                points.Intensity(i)};
+            for (int value = 0; value < kNumSummedValues; ++value) {
+                pixel_sum_[value * spherical_img_.PlaneSize() + pixel]
+                    .fetch_add(ToFixedPoint(values[value]),
+                               std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void SphericalConversion::WritePoints(const PointView& points,
+                                      const size_t begin, const size_t end,
+                                      SphericalImage* image) const {
+    // Missing channels have no plane and are skipped.
+    float* x = image->Plane(Channel::kX);
+    float* y = image->Plane(Channel::kY);
+    float* z = image->Plane(Channel::kZ);
+    float* range = image->Plane(Channel::kRange);
+    float* intensity = image->Plane(Channel::kIntensity);
+    for (size_t i = begin; i < end; ++i) {
+        const int32_t pixel = point_pixel_[i];
+        if (pixel < 0 || pixel_owner_[pixel].load(std::memory_order_relaxed) !=
+                             PointKey(i)) {
+            continue;
+        }
+        if (x) x[pixel] = points.X(i);
+        if (y) y[pixel] = points.Y(i);
+        if (z) z[pixel] = points.Z(i);
+        if (range) range[pixel] = point_range_[i];
+        if (intensity) intensity[pixel] = points.Intensity(i);
+    }
+}
+
+void SphericalConversion::FinishPixels(const size_t begin, const size_t end,
+                                       SphericalImage* image) {
+    const size_t num_pixels = image->PlaneSize();
+    float* count_plane = image->Plane(Channel::kCount);
+    for (size_t pixel = begin; pixel < end; ++pixel) {
+        const uint64_t key =
+            pixel_owner_[pixel].load(std::memory_order_relaxed);
+        pixel_owner_[pixel].store(kEmptyPixel, std::memory_order_relaxed);
+        const bool empty = key == kEmptyPixel;
+        pixel_point_[pixel] = empty ? -1 : static_cast<int32_t>(key);
+        uint32_t count = 0;
+        if (pixel_count_) {
+            count = pixel_count_[pixel].load(std::memory_order_relaxed);
+            pixel_count_[pixel].store(0, std::memory_order_relaxed);
+        }
+        if (empty) {
+            for (int channel = 0; channel < image->NumChannels();
+                 ++channel) {
+                image->Plane(channel)[pixel] = 0.0f;
+            }
+            continue;
+        }
+        if (count_plane) {
+            count_plane[pixel] = static_cast<float>(count);
+        }
+        if (!pixel_sum_) {
+            continue;
+        }
+        // The first kNumSummedValues channels are the summed values.
+        for (int value = 0; value < kNumSummedValues; ++value) {
+            auto& sum = pixel_sum_[value * num_pixels + pixel];
+            float* plane = image->Plane(static_cast<Channel>(value));
+            if (plane) {
+                plane[pixel] = static_cast<float>(
+                    sum.load(std::memory_order_relaxed) /
+                    (kFixedPointScale * count));
+            }
+            sum.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SphericalConversion::AccumulateBev(const float* x, const float* y,
+                                        const float* z, const size_t first,
+                                        const size_t count) {
+    const BevConfig& bev = config_.bev;
+    const float inv_cell_size = 1.0f / bev.cell_size;
+    const float rows = bev_img_.Rows();
+    const float cols = bev_img_.Cols();
+    const int32_t num_cols = bev_img_.Cols();
+    const int num_slices = bev_img_.NumSlices();
+    const float* slices = bev.height_slices.data();
+    const size_t num_cells = bev_img_.PlaneSize();
+    // Cell and slice of the whole block first, -1 outside of the grid.
+    int32_t cell[kBlockSize];
+    int32_t slice[kBlockSize];
+    for (size_t i = 0; i < count; ++i) {
+        const float row = (bev.x_max - x[i]) * inv_cell_size;
+        const float col = (bev.y_max - y[i]) * inv_cell_size;
+        int32_t point_slice = -1;
+        for (int bound = 0; bound <= num_slices; ++bound) {
+            point_slice += z[i] >= slices[bound];
+        }
+        const bool inside = (row >= 0.0f) & (row < rows) & (col >= 0.0f) &
+                            (col < cols) & (point_slice >= 0) &
+                            (point_slice < num_slices);
+        cell[i] = inside ? static_cast<int32_t>(row) * num_cols +
+                               static_cast<int32_t>(col)
+                         : -1;
+        slice[i] = point_slice;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (cell[i] < 0) {
+            continue;
+        }
+        // The heights are not negative, so the order of their bits is their
+        // order.
+        const uint32_t point = static_cast<uint32_t>(first + i);
+        const float height = z[i] - slices[0];
+        const uint64_t key =
+            (static_cast<uint64_t>(FloatBits(height)) << 32) |
+            (std::numeric_limits<uint32_t>::max() - point);
+        AtomicMax(bev_top_[cell[i]], key);
+        AtomicMax(bev_height_[slice[i] * num_cells + cell[i]],
+                  FloatBits(z[i] - slices[slice[i]]));
+        bev_count_[cell[i]].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SphericalConversion::FinishBev(const PointView& points,
+                                    const size_t begin, const size_t end,
+                                    BevImage* bev) {
+    const size_t num_cells = bev->PlaneSize();
+    const int num_slices = bev->NumSlices();
+    float* density = bev->DensityPlane();
+    float* intensity = bev->IntensityPlane();
+    // The density saturates at 63 points, a table avoids a log per cell.
+    constexpr uint32_t kMaxDensityCount = 63;
+    float count_density[kMaxDensityCount + 1];
+    for (uint32_t count = 0; count <= kMaxDensityCount; ++count) {
+        count_density[count] = std::min(
+            1.0f, std::log(count + 1.0f) / std::log(kMaxDensityCount + 1.0f));
+    }
+    for (size_t cell = begin; cell < end; ++cell) {
+        const uint32_t count = bev_count_[cell].load(std::memory_order_relaxed);
+        const uint64_t key = bev_top_[cell].load(std::memory_order_relaxed);
+        bev_count_[cell].store(0, std::memory_order_relaxed);
+        bev_top_[cell].store(0, std::memory_order_relaxed);
+        density[cell] = count_density[std::min(count, kMaxDensityCount)];
+        const uint32_t point = std::numeric_limits<uint32_t>::max() -
+                               static_cast<uint32_t>(key);
+        intensity[cell] = count > 0 ? points.Intensity(point) : 0.0f;
+        for (int slice = 0; slice < num_slices; ++slice) {
+            auto& height = bev_height_[slice * num_cells + cell];
+            bev->HeightPlane(slice)[cell] =
+                BitsToFloat(height.load(std::memory_order_relaxed));
+            height.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
 void SphericalConversion::GetProjection(const pcl::PointXYZI& point,
                                         const double& fov_rad,
                                         const double& fov_down_rad,
@@ -88,36 +788,162 @@ void SphericalConversion::GetProjection(const pcl::PointXYZI& point,
     *pixel_u = int(u);
 }
 
-auto SphericalConversion::GetImg() const { return spherical_img_; }
+int SphericalConversion::Unproject(const SphericalImage& image,
+                                   UnprojectedCloud* cloud) const {
+    return UnprojectPixels(image, nullptr, cloud);
+}
 
-void SphericalConversion::ShowImg(
-    const std::vector<std::vector<std::vector<double>>>& img) const {
-    cv::Mat sp_img(img.size(), img.at(0).size(), CV_64FC1);
-    for (int i = 0; i < sp_img.rows; ++i) {
-        for (int j = 0; j < sp_img.cols; ++j) {
-            sp_img.at<double>(i, j) = img.at(i).at(j).at(4);  // Intensity value
+int SphericalConversion::Unproject(const SphericalImage& image,
+                                   const std::vector<int32_t>& pixel_labels,
+                                   UnprojectedCloud* cloud) const {
+    if (pixel_labels.size() != spherical_img_.PlaneSize()) {
+        std::cerr << "Expected " << spherical_img_.PlaneSize()
+                  << " pixel labels, got " << pixel_labels.size()
+                  << std::endl;
+        return -1;
+    }
+    return UnprojectPixels(image, pixel_labels.data(), cloud);
+}
+
+int SphericalConversion::UnprojectPixels(const SphericalImage& image,
+                                         const int32_t* pixel_labels,
+                                         UnprojectedCloud* cloud) const {
+    const float* range = image.Plane(Channel::kRange);
+    if (!range) {
+        std::cerr << "The image has no range channel" << std::endl;
+        return -1;
+    }
+    if (image.Rows() != spherical_img_.Rows() ||
+        image.Cols() != spherical_img_.Cols()) {
+        std::cerr << "The image does not match the configuration" << std::endl;
+        return -1;
+    }
+    const float* intensity = image.Plane(Channel::kIntensity);
+    const size_t cols = image.Cols();
+    const size_t num_pixels = image.PlaneSize();
+    // Count the points of every chunk first, so that every chunk then writes
+    // its points from its own offset and the cloud is in pixel order for any
+    // number of threads.
+    const size_t num_chunks = NumParallelChunks(num_pixels, pool_.NumThreads());
+    std::vector<size_t> offsets(num_chunks + 1, 0);
+    pool_.ForChunks(num_pixels, [range, &offsets](const size_t chunk,
+                                                  const size_t begin,
+                                                  const size_t end) {
+        size_t count = 0;
+        for (size_t pixel = begin; pixel < end; ++pixel) {
+            count += range[pixel] > 0.0f;
+        }
+        offsets[chunk + 1] = count;
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    const size_t num_points = offsets.back();
+    cloud->x.resize(num_points);
+    cloud->y.resize(num_points);
+    cloud->z.resize(num_points);
+    cloud->intensity.resize(num_points);
+    cloud->pixel.resize(num_points);
+    if (pixel_labels) {
+        cloud->label.resize(num_points);
+    } else {
+        cloud->label.clear();
+    }
+
+    pool_.ForChunks(num_pixels, [&](const size_t chunk, const size_t begin,
+                                    const size_t end) {
+        constexpr size_t kBlockSize = 64;
+        float x[kBlockSize];
+        float y[kBlockSize];
+        float z[kBlockSize];
+        size_t point = offsets[chunk];
+        for (size_t block = begin; block < end;) {
+            // Blocks stop at the end of the rows, so the elevation is constant
+            // and the columns are contiguous in the tables.
+            const size_t row = block / cols;
+            const size_t col = block - row * cols;
+            const size_t block_size =
+                std::min({kBlockSize, end - block, cols - col});
+            const float sin_pitch = row_sin_[row];
+            const float cos_pitch = row_cos_[row];
+            const float* col_sin = col_sin_.data() + col;
+            const float* col_cos = col_cos_.data() + col;
+            const float* block_range = range + block;
+            for (size_t i = 0; i < block_size; ++i) {
+                const float planar = block_range[i] * cos_pitch;
+                x[i] = planar * col_cos[i];
+                y[i] = planar * col_sin[i];
+                z[i] = block_range[i] * sin_pitch;
+            }
+            for (size_t i = 0; i < block_size; ++i) {
+                if (!(block_range[i] > 0.0f)) {
+                    continue;
+                }
+                const size_t pixel = block + i;
+                cloud->x[point] = x[i];
+                cloud->y[point] = y[i];
+                cloud->z[point] = z[i];
+                cloud->intensity[point] = intensity ? intensity[pixel] : 0.0f;
+                cloud->pixel[point] = static_cast<int32_t>(pixel);
+                if (pixel_labels) {
+                    cloud->label[point] = pixel_labels[pixel];
+                }
+                ++point;
+            }
+            block += block_size;
+        }
+    });
+    return 1;
+}
+
+int SphericalConversion::GatherPixelLabels(
+    const std::vector<int32_t>& pixel_labels,
+    std::vector<int32_t>* point_labels, const int32_t unlabeled) const {
+    if (pixel_labels.size() != spherical_img_.PlaneSize()) {
+        std::cerr << "Expected " << spherical_img_.PlaneSize()
+                  << " pixel labels, got " << pixel_labels.size()
+                  << std::endl;
+        return -1;
+    }
+    if (point_pixel_.empty()) {
+        std::cerr << "No cloud was projected yet" << std::endl;
+        return -1;
+    }
+    const size_t num_points = point_pixel_.size();
+    point_labels->resize(num_points);
+    const int32_t* point_pixel = point_pixel_.data();
+    const int32_t* labels = pixel_labels.data();
+    int32_t* out = point_labels->data();
+    pool_.For(num_points, [=](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const int32_t pixel = point_pixel[i];
+            out[i] = pixel >= 0 ? labels[pixel] : unlabeled;
         }
+    });
+    return 1;
+}
+
+const std::vector<int32_t>& SphericalConversion::GetPointPixels() const {
+    return point_pixel_;
+}
+
+const std::vector<int32_t>& SphericalConversion::GetPixelPoints() const {
+    return pixel_point_;
+}
+
+const SphericalImage& SphericalConversion::GetImg() const {
+    return spherical_img_;
+}
+
+const BevImage& SphericalConversion::GetBev() const { return bev_img_; }
+
+void SphericalConversion::ShowImg(const SphericalImage& img,
+                                  const int wait_ms) {
+    if (!img.HasChannel(Channel::kIntensity)) {
+        std::cerr << "The image has no intensity channel" << std::endl;
+        return;
     }
+    // Wraps the intensity plane, no copy is made.
+    const cv::Mat sp_img(img.Rows(), img.Cols(), CV_32FC1,
+                         const_cast<float*>(img.Plane(Channel::kIntensity)));
     cv::imshow("Intensity Image", sp_img);
-    cv::waitKey(0);
-}
-
-int main() {
-    /** For Velodyne HDL 64-E
-     * Fov_Up = 2 degrees
-     * Fov_Down = -24.8 degrees
-     * Num of Lasers = 64
-     * Best length of image comes out to be = 1024
-     */
-    const Configuration config_input{2, -24.8, 64, 1024};
-    const std::string path =
-        "/home/" + std::string(getenv("USER")) +
-        "/OpenSource_Problems/Spherical_View_Projection/assests/"
-        "test_cloud.pcd";
-    std::cout << path << std::endl;
-    SphericalConversion conv(config_input);
-    conv.LoadCloud(path);
-    conv.MakeImage();
-    auto img = conv.GetImg();
-    conv.ShowImg(img);
+    cv::waitKey(wait_ms);
 }